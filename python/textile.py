@@ -0,0 +1,213 @@
+"""Python bindings for the textile detector.
+
+A thin ctypes layer over libtextile_c (textile/c_api.h). Frames are NumPy
+arrays, or anything exposing the buffer protocol, and are handed to the
+library by pointer without a copy as long as each row is contiguous; a
+cropped view such as frame[y0:y1, x0:x1] qualifies. Detections come back
+as a structured array of DETECTION_DTYPE.
+
+ctypes releases the GIL for the duration of each call into the library, so
+the forward pass runs without it. A Detector must not be shared between
+threads; give each thread its own (e.g. through threading.local) and the
+threads run in parallel.
+
+    import cv2, textile
+    det = textile.Detector("deploy.prototxt", "model.caffemodel")
+    frame = cv2.imread("frame.jpg")
+    for d in det.detect(frame, threshold=0.5):
+        print(d["label"], d["score"], d["xmin"], d["ymin"])
+"""
+
+import ctypes
+import ctypes.util
+import os
+
+import numpy as np
+
+__all__ = ["Detector", "TextileError", "DETECTION_DTYPE",
+           "GRAY8", "BGR24", "RGB24", "BGRA32", "RGBA32", "NV12"]
+
+API_VERSION = 2
+
+# textile_pixel_format
+GRAY8, BGR24, RGB24, BGRA32, RGBA32, NV12 = range(6)
+
+# Mirrors textile_detection.
+DETECTION_DTYPE = np.dtype([("label", "<i4"), ("score", "<f4"),
+                            ("xmin", "<f4"), ("ymin", "<f4"),
+                            ("xmax", "<f4"), ("ymax", "<f4")])
+
+_FORMATS = {"gray": GRAY8, "bgr": BGR24, "rgb": RGB24,
+            "bgra": BGRA32, "rgba": RGBA32, "nv12": NV12}
+
+# Detections per image written in the first attempt; when an image has
+# more, they are read again from the last forward pass with the exact
+# count, or the call is repeated for encoded images.
+_DEFAULT_CAPACITY = 64
+
+
+class TextileError(RuntimeError):
+    pass
+
+
+class _Image(ctypes.Structure):
+    _fields_ = [("pixels", ctypes.c_void_p),
+                ("width", ctypes.c_int32),
+                ("height", ctypes.c_int32),
+                ("stride", ctypes.c_int32),
+                ("format", ctypes.c_int32)]
+
+
+def _load_library():
+    path = (os.environ.get("TEXTILE_C_LIBRARY") or
+            ctypes.util.find_library("textile_c") or "libtextile_c.so.1")
+    lib = ctypes.CDLL(path)
+    lib.textile_api_version.restype = ctypes.c_int
+    lib.textile_api_version.argtypes = []
+    version = lib.textile_api_version()
+    if version != API_VERSION:
+        raise TextileError("%s implements API version %d, expected %d"
+                           % (path, version, API_VERSION))
+    lib.textile_last_error.restype = ctypes.c_char_p
+    lib.textile_last_error.argtypes = []
+    lib.textile_detector_create.restype = ctypes.c_int
+    lib.textile_detector_create.argtypes = [
+        ctypes.c_char_p, ctypes.c_char_p, ctypes.c_char_p,
+        ctypes.POINTER(ctypes.c_void_p)]
+    lib.textile_detector_destroy.restype = None
+    lib.textile_detector_destroy.argtypes = [ctypes.c_void_p]
+    lib.textile_detect_encoded.restype = ctypes.c_int
+    lib.textile_detect_encoded.argtypes = [
+        ctypes.c_void_p, ctypes.c_void_p, ctypes.c_size_t, ctypes.c_float,
+        ctypes.c_void_p, ctypes.c_int32, ctypes.POINTER(ctypes.c_int32)]
+    lib.textile_detect_batch.restype = ctypes.c_int
+    lib.textile_detect_batch.argtypes = [
+        ctypes.c_void_p, ctypes.POINTER(_Image), ctypes.c_int32,
+        ctypes.c_float, ctypes.c_void_p, ctypes.c_int32,
+        ctypes.POINTER(ctypes.c_int32)]
+    lib.textile_detect_last.restype = ctypes.c_int
+    lib.textile_detect_last.argtypes = [
+        ctypes.c_void_p, ctypes.c_int32, ctypes.c_void_p, ctypes.c_int32,
+        ctypes.POINTER(ctypes.c_int32)]
+    return lib
+
+
+_lib = None
+
+
+def _library():
+    global _lib
+    if _lib is None:
+        _lib = _load_library()
+    return _lib
+
+
+def _check(status):
+    if status != 0:
+        raise TextileError(_library().textile_last_error().decode())
+
+
+def _describe(frame, fmt):
+    """Return (array, textile_image) for frame, copying only when the rows
+    are not contiguous. The array keeps the pixels alive for the call."""
+    arr = np.asarray(frame)
+    if arr.dtype != np.uint8:
+        raise TypeError("frames must be uint8, got %s" % arr.dtype)
+    if fmt is None and arr.ndim == 2:
+        fmt = "gray"
+    elif fmt is None and arr.ndim == 3:
+        fmt = {1: "gray", 3: "bgr", 4: "bgra"}.get(arr.shape[2])
+    if fmt not in _FORMATS:
+        raise ValueError("unknown or ambiguous pixel format %r" % (fmt,))
+    code = _FORMATS[fmt]
+    channels = {GRAY8: 1, NV12: 1, BGR24: 3, RGB24: 3,
+                BGRA32: 4, RGBA32: 4}[code]
+    shape = arr.shape if arr.ndim == 3 else arr.shape + (1,)
+    if arr.ndim not in (2, 3) or shape[2] != channels:
+        raise ValueError("%s frames need %d channel(s), got shape %s"
+                         % (fmt, channels, arr.shape))
+    if arr.strides[1] != channels or arr.strides[-1] != 1 or \
+            arr.strides[0] <= 0:
+        arr = np.ascontiguousarray(arr)
+    height = arr.shape[0]
+    if code == NV12:
+        # The array holds the Y plane followed by the UV plane.
+        if height % 3 != 0:
+            raise ValueError("nv12 frames have height * 3 / 2 rows")
+        height = height * 2 // 3
+    image = _Image(arr.ctypes.data, arr.shape[1], height, arr.strides[0],
+                   code)
+    return arr, image
+
+
+class Detector(object):
+    """One loaded model. Not thread-safe; use one instance per thread."""
+
+    def __init__(self, model_file, weights_file, mean_value="104,117,123"):
+        self._handle = None
+        handle = ctypes.c_void_p()
+        _check(_library().textile_detector_create(
+            model_file.encode(), weights_file.encode(),
+            mean_value.encode() if mean_value else None,
+            ctypes.byref(handle)))
+        self._handle = handle
+
+    def close(self):
+        if self._handle is not None:
+            _library().textile_detector_destroy(self._handle)
+            self._handle = None
+
+    def __del__(self):
+        self.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def detect(self, frame, threshold=0.0, fmt=None):
+        """Detect on one frame: an HxW (gray), HxWx3 (BGR) or HxWx4 (BGRA)
+        uint8 array, or any of the formats named by fmt ("gray", "bgr",
+        "rgb", "bgra", "rgba", "nv12"). Returns a DETECTION_DTYPE array
+        with coordinates in pixels."""
+        return self.detect_batch([frame], threshold, fmt)[0]
+
+    def detect_batch(self, frames, threshold=0.0, fmt=None):
+        """Detect on a list of frames in one forward pass; returns one
+        DETECTION_DTYPE array per frame."""
+        if not frames:
+            return []
+        described = [_describe(f, fmt) for f in frames]
+        images = (_Image * len(described))(*[d[1] for d in described])
+        counts = np.zeros(len(described), dtype=np.int32)
+        counts_ptr = counts.ctypes.data_as(ctypes.POINTER(ctypes.c_int32))
+        capacity = _DEFAULT_CAPACITY
+        out = np.empty((len(described), capacity), dtype=DETECTION_DTYPE)
+        _check(_library().textile_detect_batch(
+            self._handle, images, len(described), threshold,
+            out.ctypes.data, capacity, counts_ptr))
+        if counts.max() > capacity:
+            # The net still holds the results; only collect them again.
+            capacity = int(counts.max())
+            out = np.empty((len(described), capacity), dtype=DETECTION_DTYPE)
+            _check(_library().textile_detect_last(
+                self._handle, len(described), out.ctypes.data, capacity,
+                counts_ptr))
+        return [out[i, :counts[i]].copy() for i in range(len(described))]
+
+    def detect_encoded(self, data, threshold=0.0):
+        """Detect on an encoded (JPEG, PNG, ...) image given as bytes or
+        any other buffer."""
+        buf = np.frombuffer(data, dtype=np.uint8)
+        count = ctypes.c_int32()
+        capacity = _DEFAULT_CAPACITY
+        while True:
+            out = np.empty(capacity, dtype=DETECTION_DTYPE)
+            _check(_library().textile_detect_encoded(
+                self._handle, buf.ctypes.data, buf.size, threshold,
+                out.ctypes.data, capacity, ctypes.byref(count)))
+            if count.value <= capacity:
+                break
+            capacity = count.value
+        return out[:count.value]
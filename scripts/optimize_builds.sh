@@ -0,0 +1,91 @@
+#!/bin/bash
+# Build the tools as baseline, LTO and LTO+PGO, train the PGO profile on the
+# benchmark scenario and report the wall time of that scenario for each build.
+#
+# Usage:
+#    scripts/optimize_builds.sh model_file weights_file list_file [file_type]
+#
+# Environment:
+#    MARCH      value for TEXTILE_MARCH (default: empty, compiler default)
+#    RUNS       timed runs per build, the best one is reported (default: 3)
+#    BUILD_ROOT where the build trees go (default: _opt_build)
+#
+set -e
+
+if [ $# -lt 3 ]; then
+  sed -n '2,12p' "$0"
+  exit 1
+fi
+
+MODEL_FILE=$(readlink -f "$1")
+WEIGHTS_FILE=$(readlink -f "$2")
+LIST_FILE=$(readlink -f "$3")
+FILE_TYPE=${4:-video}
+MARCH=${MARCH:-}
+RUNS=${RUNS:-3}
+SRC_DIR=$(cd "$(dirname "$0")/.." && pwd)
+BUILD_ROOT=$(readlink -f "${BUILD_ROOT:-_opt_build}")
+PGO_DIR="$BUILD_ROOT/profile"
+JOBS=$(nproc)
+
+configure_and_build() {
+  local name=$1
+  shift
+  cmake -S "$SRC_DIR" -B "$BUILD_ROOT/$name" -DCMAKE_BUILD_TYPE=Release \
+    -DTEXTILE_MARCH="$MARCH" -DTEXTILE_PGO_DIR="$PGO_DIR" "$@" > /dev/null
+  cmake --build "$BUILD_ROOT/$name" -j"$JOBS" > /dev/null
+}
+
+# The benchmark scenario: one pass of ssd_detect over the list file.
+run_scenario() {
+  "$BUILD_ROOT/$1/ssd_detect" -file_type "$FILE_TYPE" -out_file /dev/null \
+    "$MODEL_FILE" "$WEIGHTS_FILE" "$LIST_FILE" 2> /dev/null
+}
+
+best_time() {
+  local best=""
+  for _ in $(seq "$RUNS"); do
+    local start end elapsed
+    start=$(date +%s.%N)
+    run_scenario "$1"
+    end=$(date +%s.%N)
+    elapsed=$(echo "$end - $start" | bc)
+    if [ -z "$best" ] || [ "$(echo "$elapsed < $best" | bc)" = 1 ]; then
+      best=$elapsed
+    fi
+  done
+  echo "$best"
+}
+
+echo "Building baseline ..."
+configure_and_build baseline
+echo "Building LTO ..."
+configure_and_build lto -DTEXTILE_LTO=ON
+
+echo "Training PGO profile ..."
+rm -rf "$PGO_DIR"
+mkdir -p "$PGO_DIR"
+# Both stages build in the same directory: GCC profiles are looked up by
+# the paths of the object files that wrote them.
+rm -rf "$BUILD_ROOT/pgo"
+configure_and_build pgo -DTEXTILE_LTO=ON -DTEXTILE_PGO=GENERATE
+run_scenario pgo
+if ls "$PGO_DIR"/*.profraw > /dev/null 2>&1; then
+  llvm-profdata merge -o "$PGO_DIR/textile.profdata" "$PGO_DIR"/*.profraw
+fi
+
+echo "Building LTO+PGO ..."
+configure_and_build pgo -DTEXTILE_LTO=ON -DTEXTILE_PGO=USE
+
+declare -A TIMES
+for build in baseline lto pgo; do
+  TIMES[$build]=$(best_time $build)
+done
+
+BASE=${TIMES[baseline]}
+printf "%-10s %10s %8s\n" build "time (s)" gain
+for build in baseline lto pgo; do
+  t=${TIMES[$build]}
+  gain=$(echo "scale=1; 100 * ($BASE - $t) / $BASE" | bc)
+  printf "%-10s %10.3f %7s%%\n" $build "$t" "$gain"
+done
@@ -0,0 +1,168 @@
+#include "textile/allocator.hpp"
+
+#include <malloc.h>
+#include <stddef.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <glog/logging.h>
+
+#if defined(USE_JEMALLOC)
+#include <jemalloc/jemalloc.h>
+#elif defined(USE_TCMALLOC)
+#include <gperftools/malloc_extension.h>
+#elif defined(USE_MIMALLOC)
+#include <mimalloc.h>
+#endif
+
+namespace textile {
+
+const char* AllocatorName() {
+#if defined(USE_JEMALLOC)
+  return "jemalloc";
+#elif defined(USE_TCMALLOC)
+  return "tcmalloc";
+#elif defined(USE_MIMALLOC)
+  return "mimalloc";
+#else
+  return "glibc";
+#endif
+}
+
+#if defined(USE_JEMALLOC)
+static int64_t JemallocStat(const char* name) {
+  size_t value = 0;
+  size_t len = sizeof(value);
+  if (mallctl(name, &value, &len, NULL, 0) != 0) {
+    return 0;
+  }
+  return value;
+}
+#elif defined(USE_TCMALLOC)
+static int64_t TcmallocStat(const char* name) {
+  size_t value = 0;
+  if (!MallocExtension::instance()->GetNumericProperty(name, &value)) {
+    return 0;
+  }
+  return value;
+}
+#endif
+
+#if defined(USE_JEMALLOC)
+/* Cap on the arenas BindThreadArena creates; past it, threads share the
+ * ones created so far in turn. */
+static int max_thread_arenas = 0;
+static std::mutex thread_arenas_mutex;
+static std::vector<unsigned> thread_arenas;
+static size_t next_thread_arena = 0;
+#endif
+
+void ConfigureAllocator(int max_arenas, int64_t mmap_threshold) {
+#if defined(USE_JEMALLOC)
+  // The automatic arenas are created when jemalloc starts, before main(),
+  // from opt.narenas, which is read-only afterwards; only MALLOC_CONF can
+  // set it. The arenas of our own threads are capped here.
+  if (max_arenas > 0) {
+    max_thread_arenas = max_arenas;
+    unsigned narenas = 0;
+    size_t len = sizeof(narenas);
+    if (mallctl("opt.narenas", &narenas, &len, NULL, 0) == 0 &&
+        narenas > static_cast<unsigned>(max_arenas)) {
+      LOG(WARNING) << "jemalloc runs " << narenas << " automatic arenas;"
+                   << " start with MALLOC_CONF=narenas:" << max_arenas
+                   << " to cap them too";
+    }
+  }
+  (void)mmap_threshold;
+#elif defined(USE_TCMALLOC) || defined(USE_MIMALLOC)
+  // Per-thread caches and heaps instead of arenas: nothing to cap.
+  if (max_arenas > 0) {
+    LOG(WARNING) << AllocatorName() << " has no arenas to cap; ignoring "
+                 << max_arenas;
+  }
+  (void)mmap_threshold;
+#else
+  if (max_arenas > 0) {
+    mallopt(M_ARENA_MAX, max_arenas);
+  }
+  if (mmap_threshold > 0) {
+    mallopt(M_MMAP_THRESHOLD, static_cast<int>(mmap_threshold));
+  }
+#endif
+}
+
+bool BindThreadArena() {
+#if defined(USE_JEMALLOC)
+  unsigned arena = 0;
+  {
+    std::lock_guard<std::mutex> lock(thread_arenas_mutex);
+    if (max_thread_arenas > 0 &&
+        thread_arenas.size() >= static_cast<size_t>(max_thread_arenas)) {
+      arena = thread_arenas[next_thread_arena++ % thread_arenas.size()];
+    } else {
+      size_t len = sizeof(arena);
+      if (mallctl("arenas.create", &arena, &len, NULL, 0) != 0) {
+        return false;
+      }
+      thread_arenas.push_back(arena);
+    }
+  }
+  return mallctl("thread.arena", NULL, NULL, &arena, sizeof(arena)) == 0;
+#else
+  return true;
+#endif
+}
+
+AllocatorStats GetAllocatorStats() {
+  AllocatorStats stats;
+#if defined(USE_JEMALLOC)
+  // Statistics are cached by jemalloc until the epoch is advanced.
+  uint64_t epoch = 1;
+  size_t len = sizeof(epoch);
+  mallctl("epoch", &epoch, &len, &epoch, len);
+  stats.allocated = JemallocStat("stats.allocated");
+  stats.active = JemallocStat("stats.active");
+  stats.resident = JemallocStat("stats.resident");
+  stats.mapped = JemallocStat("stats.mapped");
+#elif defined(USE_TCMALLOC)
+  stats.allocated = TcmallocStat("generic.current_allocated_bytes");
+  stats.mapped = TcmallocStat("generic.heap_size");
+  stats.resident =
+      stats.mapped - TcmallocStat("tcmalloc.pageheap_unmapped_bytes");
+  stats.active = stats.resident - TcmallocStat("tcmalloc.pageheap_free_bytes");
+#elif defined(USE_MIMALLOC)
+  size_t elapsed, user, sys, rss, peak_rss, commit, peak_commit, faults;
+  mi_process_info(&elapsed, &user, &sys, &rss, &peak_rss, &commit,
+                  &peak_commit, &faults);
+  stats.allocated = commit;
+  stats.active = commit;
+  stats.resident = rss;
+  stats.mapped = commit;
+#else
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+  struct mallinfo2 mi = mallinfo2();
+#else
+  struct mallinfo mi = mallinfo();
+#endif
+  stats.allocated = static_cast<int64_t>(mi.uordblks) + mi.hblkhd;
+  stats.active = stats.allocated;
+  stats.mapped = static_cast<int64_t>(mi.arena) + mi.hblkhd;
+  // glibc cannot tell which free arena pages were returned to the OS.
+  stats.resident = stats.mapped;
+#endif
+  return stats;
+}
+
+void ExportAllocatorStats(Metrics* metrics) {
+  const AllocatorStats stats = GetAllocatorStats();
+  const std::string label =
+      std::string("{allocator=\"") + AllocatorName() + "\"}";
+  metrics->Set("textile_allocator_allocated_bytes" + label, stats.allocated);
+  metrics->Set("textile_allocator_active_bytes" + label, stats.active);
+  metrics->Set("textile_allocator_resident_bytes" + label, stats.resident);
+  metrics->Set("textile_allocator_mapped_bytes" + label, stats.mapped);
+}
+
+}  // namespace textile
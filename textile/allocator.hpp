@@ -0,0 +1,54 @@
+// Build-time selection of the heap allocator, and its statistics.
+//
+// Define exactly one of USE_JEMALLOC, USE_TCMALLOC or USE_MIMALLOC and link
+// the matching library (-ljemalloc, -ltcmalloc_minimal, -lmimalloc) to
+// replace glibc malloc for the whole process. Without any of them glibc
+// malloc is kept and tuned so that frame-sized buffers stay out of the
+// arenas.
+//
+// Pipeline threads call BindThreadArena() once when they start so that their
+// short-lived allocations (detection vectors, queue nodes) do not interleave
+// with the large frame buffers of other threads.
+//
+#ifndef TEXTILE_ALLOCATOR_HPP_
+#define TEXTILE_ALLOCATOR_HPP_
+
+#include <stdint.h>
+
+#include "textile/metrics.hpp"
+
+namespace textile {
+
+struct AllocatorStats {
+  AllocatorStats() : allocated(0), active(0), resident(0), mapped(0) {}
+
+  int64_t allocated;  // bytes handed out to the application
+  int64_t active;     // bytes in pages backing those allocations
+  int64_t resident;   // bytes the allocator keeps resident
+  int64_t mapped;     // bytes mapped from the OS
+};
+
+const char* AllocatorName();
+
+/* Process-wide tuning, called once at startup before any pipeline thread is
+ * started. max_arenas <= 0 keeps the allocator's default. glibc caps all
+ * its arenas; jemalloc caps those BindThreadArena creates and warns unless
+ * MALLOC_CONF capped its automatic ones; tcmalloc and mimalloc have none
+ * and warn. mmap_threshold is only meaningful for glibc, where a fixed
+ * threshold stops the dynamic one from growing until whole frames are
+ * carved out of (and fragment) the arenas. */
+void ConfigureAllocator(int max_arenas, int64_t mmap_threshold);
+
+/* Give the calling thread an arena of its own, or a shared one past the cap
+ * of ConfigureAllocator. Returns false when the allocator could not create
+ * one; tcmalloc and mimalloc already keep per-thread caches/heaps, and
+ * glibc assigns arenas per thread by itself. */
+bool BindThreadArena();
+
+AllocatorStats GetAllocatorStats();
+
+void ExportAllocatorStats(Metrics* metrics);
+
+}  // namespace textile
+
+#endif  // TEXTILE_ALLOCATOR_HPP_
@@ -0,0 +1,205 @@
+#include "textile/box_set.hpp"
+
+#include <math.h>
+
+#include <algorithm>
+
+namespace textile {
+
+void BoxSet::Clear() {
+  xmin_.clear();
+  ymin_.clear();
+  xmax_.clear();
+  ymax_.clear();
+  area_.clear();
+  score_.clear();
+  label_.clear();
+}
+
+void BoxSet::Reserve(int n) {
+  xmin_.reserve(n);
+  ymin_.reserve(n);
+  xmax_.reserve(n);
+  ymax_.reserve(n);
+  area_.reserve(n);
+  score_.reserve(n);
+  label_.reserve(n);
+}
+
+void BoxSet::Add(int label, float score, float xmin, float ymin, float xmax,
+                 float ymax) {
+  xmin_.push_back(xmin);
+  ymin_.push_back(ymin);
+  xmax_.push_back(xmax);
+  ymax_.push_back(ymax);
+  area_.push_back(std::max(xmax - xmin, 0.f) * std::max(ymax - ymin, 0.f));
+  score_.push_back(score);
+  label_.push_back(label);
+}
+
+BoxSuppressor::BoxSuppressor(const Kernels& kernels) : kernels_(kernels) {}
+
+void BoxSuppressor::IouMatrix(const BoxSet& boxes, std::vector<float>* iou) {
+  IouMatrix(boxes, boxes, iou);
+}
+
+void BoxSuppressor::IouMatrix(const BoxSet& rows, const BoxSet& cols,
+                              std::vector<float>* iou) {
+  const int n = cols.size();
+  iou->resize(static_cast<size_t>(rows.size()) * n);
+  for (int i = 0; i < rows.size(); ++i) {
+    kernels_.iou_row(rows.xmin_[i], rows.ymin_[i], rows.xmax_[i],
+                     rows.ymax_[i], rows.area_[i], cols.xmin(), cols.ymin(),
+                     cols.xmax(), cols.ymax(), cols.area(), n,
+                     iou->data() + static_cast<size_t>(i) * n);
+  }
+}
+
+void BoxSuppressor::Sort(const BoxSet& boxes, bool class_aware) {
+  const int n = boxes.size();
+  order_.resize(n);
+  for (int i = 0; i < n; ++i) {
+    order_[i] = i;
+  }
+  // Ties go to the lower index, so that every variant keeps the same boxes.
+  std::sort(order_.begin(), order_.end(), [&](int a, int b) {
+    if (class_aware && boxes.label_[a] != boxes.label_[b]) {
+      return boxes.label_[a] < boxes.label_[b];
+    }
+    if (boxes.score_[a] != boxes.score_[b]) {
+      return boxes.score_[a] > boxes.score_[b];
+    }
+    return a < b;
+  });
+  sorted_.Clear();
+  sorted_.Reserve(n);
+  ranges_.clear();
+  for (int i = 0; i < n; ++i) {
+    const int k = order_[i];
+    if (i == 0 || (class_aware && boxes.label_[k] != sorted_.label_.back())) {
+      ranges_.push_back(i);
+    }
+    sorted_.xmin_.push_back(boxes.xmin_[k]);
+    sorted_.ymin_.push_back(boxes.ymin_[k]);
+    sorted_.xmax_.push_back(boxes.xmax_[k]);
+    sorted_.ymax_.push_back(boxes.ymax_[k]);
+    sorted_.area_.push_back(boxes.area_[k]);
+    sorted_.score_.push_back(boxes.score_[k]);
+    sorted_.label_.push_back(boxes.label_[k]);
+  }
+  ranges_.push_back(n);
+  row_.resize(n);
+}
+
+void BoxSuppressor::IouRow(int i, int begin, int end) {
+  kernels_.iou_row(sorted_.xmin_[i], sorted_.ymin_[i], sorted_.xmax_[i],
+                   sorted_.ymax_[i], sorted_.area_[i],
+                   sorted_.xmin() + begin, sorted_.ymin() + begin,
+                   sorted_.xmax() + begin, sorted_.ymax() + begin,
+                   sorted_.area() + begin, end - begin, row_.data() + begin);
+}
+
+/* Put keep (indices into boxes, with scores) in descending score order;
+ * ties go to the lower index. */
+static void SortKept(const std::vector<float>& kept_scores,
+                     std::vector<int>* keep, std::vector<float>* scores) {
+  std::vector<int> order(keep->size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = static_cast<int>(i);
+  }
+  std::sort(order.begin(), order.end(), [&](int a, int b) {
+    if (kept_scores[a] != kept_scores[b]) {
+      return kept_scores[a] > kept_scores[b];
+    }
+    return (*keep)[a] < (*keep)[b];
+  });
+  std::vector<int> sorted_keep(keep->size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    sorted_keep[i] = (*keep)[order[i]];
+    if (scores != NULL) {
+      (*scores)[i] = kept_scores[order[i]];
+    }
+  }
+  keep->swap(sorted_keep);
+}
+
+void BoxSuppressor::Nms(const BoxSet& boxes, float max_iou, bool class_aware,
+                        std::vector<int>* keep) {
+  keep->clear();
+  if (boxes.empty()) {
+    return;
+  }
+  Sort(boxes, class_aware);
+  active_.assign(boxes.size(), 1);
+  scores_.clear();
+  for (size_t r = 0; r + 1 < ranges_.size(); ++r) {
+    const int end = ranges_[r + 1];
+    for (int i = ranges_[r]; i < end; ++i) {
+      if (!active_[i]) {
+        continue;
+      }
+      keep->push_back(order_[i]);
+      scores_.push_back(sorted_.score_[i]);
+      // Only the lower-scored boxes of the group can still be suppressed.
+      IouRow(i, i + 1, end);
+      for (int j = i + 1; j < end; ++j) {
+        if (row_[j] > max_iou) {
+          active_[j] = 0;
+        }
+      }
+    }
+  }
+  if (class_aware && ranges_.size() > 2) {
+    SortKept(scores_, keep, NULL);
+  }
+}
+
+void BoxSuppressor::SoftNms(const BoxSet& boxes, float sigma,
+                            float min_score, bool class_aware,
+                            std::vector<int>* keep,
+                            std::vector<float>* scores) {
+  keep->clear();
+  scores->clear();
+  if (boxes.empty()) {
+    return;
+  }
+  Sort(boxes, class_aware);
+  active_.resize(boxes.size());
+  for (int i = 0; i < boxes.size(); ++i) {
+    active_[i] = sorted_.score_[i] >= min_score;
+  }
+  // Decayed scores, in sorted_ order.
+  std::vector<float>& decayed = sorted_.score_;
+  for (size_t r = 0; r + 1 < ranges_.size(); ++r) {
+    const int begin = ranges_[r];
+    const int end = ranges_[r + 1];
+    while (true) {
+      // Decay reorders the scores: look for the best remaining box.
+      int best = -1;
+      for (int i = begin; i < end; ++i) {
+        if (active_[i] && (best < 0 || decayed[i] > decayed[best])) {
+          best = i;
+        }
+      }
+      if (best < 0) {
+        break;
+      }
+      active_[best] = 0;
+      keep->push_back(order_[best]);
+      scores->push_back(decayed[best]);
+      IouRow(best, begin, end);
+      for (int j = begin; j < end; ++j) {
+        if (active_[j] && row_[j] > 0.f) {
+          decayed[j] *= expf(-row_[j] * row_[j] / sigma);
+          active_[j] = decayed[j] >= min_score;
+        }
+      }
+    }
+  }
+  if (class_aware && ranges_.size() > 2) {
+    scores_ = *scores;
+    SortKept(scores_, keep, scores);
+  }
+}
+
+}  // namespace textile
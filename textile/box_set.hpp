@@ -0,0 +1,94 @@
+// Boxes in structure-of-arrays layout, and IoU/NMS over them.
+//
+// Keeping each coordinate in its own array lets the IoU of one box with
+// all the others run as the iou_row kernel of kernels.hpp, 8 or 16 boxes
+// per instruction. The suppression routines sort the boxes into scratch
+// arrays of a BoxSuppressor, so that the boxes a kept box is compared with
+// are contiguous, and reuse those arrays from call to call.
+//
+#ifndef TEXTILE_BOX_SET_HPP_
+#define TEXTILE_BOX_SET_HPP_
+
+#include <vector>
+
+#include "textile/kernels.hpp"
+
+namespace textile {
+
+class BoxSet {
+ public:
+  void Clear();
+  void Reserve(int n);
+  void Add(int label, float score, float xmin, float ymin, float xmax,
+           float ymax);
+
+  int size() const { return static_cast<int>(xmin_.size()); }
+  bool empty() const { return xmin_.empty(); }
+
+  const float* xmin() const { return xmin_.data(); }
+  const float* ymin() const { return ymin_.data(); }
+  const float* xmax() const { return xmax_.data(); }
+  const float* ymax() const { return ymax_.data(); }
+  /* Area of each box, kept so that IoU does not recompute it. */
+  const float* area() const { return area_.data(); }
+  const float* score() const { return score_.data(); }
+  const int* label() const { return label_.data(); }
+
+ private:
+  friend class BoxSuppressor;
+
+  std::vector<float> xmin_;
+  std::vector<float> ymin_;
+  std::vector<float> xmax_;
+  std::vector<float> ymax_;
+  std::vector<float> area_;
+  std::vector<float> score_;
+  std::vector<int> label_;
+};
+
+class BoxSuppressor {
+ public:
+  /* Run on the given kernels; the default binds to the CPU's best. */
+  explicit BoxSuppressor(const Kernels& kernels = GetKernels());
+
+  /* iou[i * n + j] for the n boxes. */
+  void IouMatrix(const BoxSet& boxes, std::vector<float>* iou);
+  /* iou[i * cols.size() + j] of rows box i and cols box j. */
+  void IouMatrix(const BoxSet& rows, const BoxSet& cols,
+                 std::vector<float>* iou);
+
+  /* Greedy NMS: from the highest score down, keep a box unless it overlaps
+   * a kept one by more than max_iou. With class_aware, boxes of different
+   * labels never suppress each other. keep gets the indices of the kept
+   * boxes by descending score. */
+  void Nms(const BoxSet& boxes, float max_iou, bool class_aware,
+           std::vector<int>* keep);
+
+  /* Gaussian soft-NMS: instead of dropping the boxes overlapping a kept
+   * one, their scores are multiplied by exp(-iou^2 / sigma); boxes whose
+   * score falls below min_score are dropped. keep gets the indices of the
+   * kept boxes and scores their decayed scores, by descending score. */
+  void SoftNms(const BoxSet& boxes, float sigma, float min_score,
+               bool class_aware, std::vector<int>* keep,
+               std::vector<float>* scores);
+
+ private:
+  /* Copy boxes into sorted_ by descending score (grouped by label first
+   * with class_aware), order_ mapping back; fills ranges_ with the
+   * [begin, end) of each group. */
+  void Sort(const BoxSet& boxes, bool class_aware);
+  /* IoU of sorted_ box i with sorted_ boxes [begin, end) into row_. */
+  void IouRow(int i, int begin, int end);
+
+  const Kernels& kernels_;
+  BoxSet sorted_;
+  std::vector<int> order_;
+  std::vector<int> ranges_;
+  std::vector<float> row_;
+  std::vector<float> scores_;
+  std::vector<char> active_;
+};
+
+}  // namespace textile
+
+#endif  // TEXTILE_BOX_SET_HPP_
@@ -0,0 +1,281 @@
+#include "textile/c_api.h"
+
+#include <sys/stat.h>
+
+#include <exception>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "textile/detector.hpp"
+
+struct textile_detector {
+  textile_detector(const std::string& model_file,
+                   const std::string& weights_file,
+                   const std::string& mean_value)
+      : detector(model_file, weights_file, "", mean_value), last_num(0),
+        last_threshold(0.f) {}
+
+  textile::Detector detector;
+  /* Targets of the formats the detector cannot take as they are, one per
+   * image of a batch; reused from call to call. */
+  std::vector<cv::Mat> converted;
+  std::vector<cv::Mat> images;
+  std::vector<int> counts;
+  /* Of the last forward pass, whose results the net still holds; images
+   * keeps the sizes of its inputs. */
+  int last_num;
+  float last_threshold;
+};
+
+namespace {
+
+thread_local std::string last_error;
+
+textile_status Fail(textile_status status, const std::string& message) {
+  last_error = message;
+  return status;
+}
+
+bool FileExists(const char* path) {
+  struct stat st;
+  return path != NULL && stat(path, &st) == 0;
+}
+
+/* Point *wrapped at the image, converting it into *converted when its
+ * format cannot be fed to the detector as it is. */
+textile_status WrapImage(const textile_image& image, cv::Mat* converted,
+                         cv::Mat* wrapped) {
+  if (image.pixels == NULL) {
+    return Fail(TEXTILE_ERROR_INVALID_ARGUMENT, "NULL pixels");
+  }
+  if (image.width <= 0 || image.height <= 0) {
+    return Fail(TEXTILE_ERROR_INVALID_ARGUMENT, "empty image");
+  }
+  int type = CV_8UC3;
+  int bytes_per_pixel = 3;
+  int rows = image.height;
+  switch (image.format) {
+    case TEXTILE_FORMAT_GRAY8:
+      type = CV_8UC1;
+      bytes_per_pixel = 1;
+      break;
+    case TEXTILE_FORMAT_BGR24:
+    case TEXTILE_FORMAT_RGB24:
+      break;
+    case TEXTILE_FORMAT_BGRA32:
+    case TEXTILE_FORMAT_RGBA32:
+      type = CV_8UC4;
+      bytes_per_pixel = 4;
+      break;
+    case TEXTILE_FORMAT_NV12:
+      if (image.width % 2 != 0 || image.height % 2 != 0) {
+        return Fail(TEXTILE_ERROR_INVALID_ARGUMENT, "NV12 needs even sizes");
+      }
+      type = CV_8UC1;
+      bytes_per_pixel = 1;
+      rows = image.height * 3 / 2;
+      break;
+    default:
+      return Fail(TEXTILE_ERROR_INVALID_ARGUMENT, "unknown pixel format");
+  }
+  if (image.stride < image.width * bytes_per_pixel) {
+    return Fail(TEXTILE_ERROR_INVALID_ARGUMENT, "stride is too small");
+  }
+
+  // A header over the caller's pixels; nothing is copied here.
+  *wrapped = cv::Mat(rows, image.width, type,
+                     const_cast<uint8_t*>(image.pixels), image.stride);
+  switch (image.format) {
+    case TEXTILE_FORMAT_RGB24:
+      cv::cvtColor(*wrapped, *converted, cv::COLOR_RGB2BGR);
+      break;
+    case TEXTILE_FORMAT_RGBA32:
+      cv::cvtColor(*wrapped, *converted, cv::COLOR_RGBA2BGR);
+      break;
+    case TEXTILE_FORMAT_NV12:
+      cv::cvtColor(*wrapped, *converted, cv::COLOR_YUV2BGR_NV12);
+      break;
+    default:
+      // Gray, BGR and BGRA are read by the detector in place.
+      return TEXTILE_OK;
+  }
+  *wrapped = *converted;
+  return TEXTILE_OK;
+}
+
+/* Detect on handle->images[0, num). */
+textile_status Run(textile_detector* handle, int num, float threshold,
+                   textile_detection* detections, int32_t capacity,
+                   int32_t* counts) {
+  // textile_detection and textile::Detection are laid out alike so that
+  // the results are written straight into the caller's array.
+  static_assert(sizeof(textile_detection) == sizeof(textile::Detection),
+                "textile_detection must mirror textile::Detection");
+  // The caller may use a handle from a thread other than the one that
+  // created it.
+  textile::BindCaffeMode();
+  handle->last_num = 0;
+  handle->counts.resize(num);
+  handle->detector.DetectBatch(
+      &handle->images[0], num, threshold,
+      reinterpret_cast<textile::Detection*>(detections), capacity,
+      &handle->counts[0]);
+  handle->last_num = num;
+  handle->last_threshold = threshold;
+  for (int i = 0; i < num; ++i) {
+    counts[i] = handle->counts[i];
+  }
+  return TEXTILE_OK;
+}
+
+}  // namespace
+
+extern "C" {
+
+int textile_api_version(void) {
+  return TEXTILE_API_VERSION;
+}
+
+const char* textile_last_error(void) {
+  return last_error.c_str();
+}
+
+textile_status textile_detector_create(const char* model_file,
+                                       const char* weights_file,
+                                       const char* mean_value,
+                                       textile_detector** detector) {
+  if (detector == NULL) {
+    return Fail(TEXTILE_ERROR_INVALID_ARGUMENT, "detector is NULL");
+  }
+  // Caffe aborts on missing files, so check them here first.
+  if (!FileExists(model_file)) {
+    return Fail(TEXTILE_ERROR_INVALID_ARGUMENT, "cannot read model_file");
+  }
+  if (!FileExists(weights_file)) {
+    return Fail(TEXTILE_ERROR_INVALID_ARGUMENT, "cannot read weights_file");
+  }
+  try {
+    *detector = new textile_detector(model_file, weights_file,
+        mean_value != NULL ? mean_value : "104,117,123");
+  } catch (const std::exception& e) {
+    return Fail(TEXTILE_ERROR_INTERNAL, e.what());
+  }
+  return TEXTILE_OK;
+}
+
+void textile_detector_destroy(textile_detector* detector) {
+  delete detector;
+}
+
+textile_status textile_detect_raw(textile_detector* detector,
+                                  const uint8_t* pixels, int32_t width,
+                                  int32_t height, int32_t stride,
+                                  textile_pixel_format format,
+                                  float threshold,
+                                  textile_detection* detections,
+                                  int32_t capacity, int32_t* count) {
+  textile_image image;
+  image.pixels = pixels;
+  image.width = width;
+  image.height = height;
+  image.stride = stride;
+  image.format = format;
+  return textile_detect_batch(detector, &image, 1, threshold, detections,
+                              capacity, count);
+}
+
+textile_status textile_detect_batch(textile_detector* detector,
+                                    const textile_image* images,
+                                    int32_t num, float threshold,
+                                    textile_detection* detections,
+                                    int32_t capacity, int32_t* counts) {
+  if (detector == NULL || images == NULL || counts == NULL ||
+      (detections == NULL && capacity > 0)) {
+    return Fail(TEXTILE_ERROR_INVALID_ARGUMENT, "NULL argument");
+  }
+  if (num <= 0 || capacity < 0) {
+    return Fail(TEXTILE_ERROR_INVALID_ARGUMENT, "bad num or capacity");
+  }
+  try {
+    if (detector->converted.size() < static_cast<size_t>(num)) {
+      detector->converted.resize(num);
+    }
+    detector->images.resize(num);
+    for (int i = 0; i < num; ++i) {
+      textile_status status = WrapImage(images[i], &detector->converted[i],
+                                        &detector->images[i]);
+      if (status != TEXTILE_OK) {
+        return status;
+      }
+    }
+    return Run(detector, num, threshold, detections, capacity, counts);
+  } catch (const std::exception& e) {
+    return Fail(TEXTILE_ERROR_INTERNAL, e.what());
+  }
+}
+
+textile_status textile_detect_encoded(textile_detector* detector,
+                                      const uint8_t* data, size_t size,
+                                      float threshold,
+                                      textile_detection* detections,
+                                      int32_t capacity, int32_t* count) {
+  if (detector == NULL || data == NULL || count == NULL ||
+      (detections == NULL && capacity > 0)) {
+    return Fail(TEXTILE_ERROR_INVALID_ARGUMENT, "NULL argument");
+  }
+  if (size == 0) {
+    return Fail(TEXTILE_ERROR_INVALID_ARGUMENT, "empty buffer");
+  }
+  if (capacity < 0) {
+    return Fail(TEXTILE_ERROR_INVALID_ARGUMENT, "bad capacity");
+  }
+  try {
+    if (detector->converted.empty()) {
+      detector->converted.resize(1);
+    }
+    // imdecode reads the bytes through this header in place.
+    const cv::Mat encoded(1, static_cast<int>(size), CV_8UC1,
+                          const_cast<uint8_t*>(data));
+    cv::imdecode(encoded, cv::IMREAD_COLOR, &detector->converted[0]);
+    if (detector->converted[0].empty()) {
+      return Fail(TEXTILE_ERROR_DECODE, "unable to decode image");
+    }
+    detector->images.assign(1, detector->converted[0]);
+    return Run(detector, 1, threshold, detections, capacity, count);
+  } catch (const std::exception& e) {
+    return Fail(TEXTILE_ERROR_INTERNAL, e.what());
+  }
+}
+
+textile_status textile_detect_last(textile_detector* detector, int32_t num,
+                                   textile_detection* detections,
+                                   int32_t capacity, int32_t* counts) {
+  if (detector == NULL || counts == NULL ||
+      (detections == NULL && capacity > 0)) {
+    return Fail(TEXTILE_ERROR_INVALID_ARGUMENT, "NULL argument");
+  }
+  if (detector->last_num == 0) {
+    return Fail(TEXTILE_ERROR_INVALID_ARGUMENT, "no detect call to repeat");
+  }
+  if (num != detector->last_num || capacity < 0) {
+    return Fail(TEXTILE_ERROR_INVALID_ARGUMENT, "bad num or capacity");
+  }
+  try {
+    detector->detector.Collect(
+        &detector->images[0], num, detector->last_threshold,
+        reinterpret_cast<textile::Detection*>(detections), capacity,
+        &detector->counts[0]);
+    for (int i = 0; i < num; ++i) {
+      counts[i] = detector->counts[i];
+    }
+    return TEXTILE_OK;
+  } catch (const std::exception& e) {
+    return Fail(TEXTILE_ERROR_INTERNAL, e.what());
+  }
+}
+
+}  // extern "C"
@@ -0,0 +1,120 @@
+/* Stable C interface to the textile detector, for embedding in other
+ * applications.
+ *
+ * Images are passed as pointers into the caller's memory and are read in
+ * place; results are written into caller-provided arrays. A detector
+ * handle may be used from any thread, but from one thread at a time; use
+ * one handle per thread to run detections in parallel.
+ *
+ * Only opaque handles, fixed-size integers, floats and plain structs cross
+ * this boundary, so the ABI stays stable as long as TEXTILE_API_VERSION
+ * does not change. Version 2 added textile_detect_last.
+ */
+#ifndef TEXTILE_C_API_H_
+#define TEXTILE_C_API_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define TEXTILE_API __attribute__((visibility("default")))
+#else
+#define TEXTILE_API
+#endif
+
+#define TEXTILE_API_VERSION 2
+
+typedef struct textile_detector textile_detector;
+
+typedef enum textile_status {
+  TEXTILE_OK = 0,
+  TEXTILE_ERROR_INVALID_ARGUMENT = 1,
+  TEXTILE_ERROR_DECODE = 2,
+  TEXTILE_ERROR_INTERNAL = 3
+} textile_status;
+
+/* Pixel layouts accepted by textile_detect_raw. NV12 expects the
+ * interleaved UV plane to follow the Y plane directly (height rows of
+ * stride bytes each). */
+typedef enum textile_pixel_format {
+  TEXTILE_FORMAT_GRAY8 = 0,
+  TEXTILE_FORMAT_BGR24 = 1,
+  TEXTILE_FORMAT_RGB24 = 2,
+  TEXTILE_FORMAT_BGRA32 = 3,
+  TEXTILE_FORMAT_RGBA32 = 4,
+  TEXTILE_FORMAT_NV12 = 5
+} textile_pixel_format;
+
+/* One detection, in pixels of the input image. */
+typedef struct textile_detection {
+  int32_t label;
+  float score;
+  float xmin;
+  float ymin;
+  float xmax;
+  float ymax;
+} textile_detection;
+
+/* One raw image of a batch; the fields are those of textile_detect_raw. */
+typedef struct textile_image {
+  const uint8_t* pixels;
+  int32_t width;
+  int32_t height;
+  int32_t stride;
+  int32_t format;  /* textile_pixel_format */
+} textile_image;
+
+/* TEXTILE_API_VERSION of the library actually loaded. */
+TEXTILE_API int textile_api_version(void);
+
+/* Message of the last failed call on this thread; never NULL. */
+TEXTILE_API const char* textile_last_error(void);
+
+/* Load a model. mean_value is "b,g,r" (or one value); NULL selects the
+ * default of the tools, "104,117,123". */
+TEXTILE_API textile_status textile_detector_create(
+    const char* model_file, const char* weights_file,
+    const char* mean_value, textile_detector** detector);
+
+TEXTILE_API void textile_detector_destroy(textile_detector* detector);
+
+/* Detect on raw pixels. stride is the distance in bytes between two rows.
+ * Up to capacity detections with a score of at least threshold are written
+ * to detections; *count receives how many there were in total. */
+TEXTILE_API textile_status textile_detect_raw(
+    textile_detector* detector, const uint8_t* pixels, int32_t width,
+    int32_t height, int32_t stride, textile_pixel_format format,
+    float threshold, textile_detection* detections, int32_t capacity,
+    int32_t* count);
+
+/* Same for an encoded image (JPEG, PNG, ...) of size bytes. */
+TEXTILE_API textile_status textile_detect_encoded(
+    textile_detector* detector, const uint8_t* data, size_t size,
+    float threshold, textile_detection* detections, int32_t capacity,
+    int32_t* count);
+
+/* Detect on num images in one forward pass. Image i gets the slots
+ * detections[i * capacity, (i + 1) * capacity) and counts[i] receives its
+ * total number of detections. */
+TEXTILE_API textile_status textile_detect_batch(
+    textile_detector* detector, const textile_image* images, int32_t num,
+    float threshold, textile_detection* detections, int32_t capacity,
+    int32_t* counts);
+
+/* Write the detections of the last detect call on detector again, without
+ * running the net: into an array sized from the counts that call returned,
+ * when some exceeded its capacity. The arguments are those of
+ * textile_detect_batch; num is that of the last call. */
+TEXTILE_API textile_status textile_detect_last(
+    textile_detector* detector, int32_t num, textile_detection* detections,
+    int32_t capacity, int32_t* counts);
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif  /* TEXTILE_C_API_H_ */
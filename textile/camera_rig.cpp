@@ -0,0 +1,67 @@
+#include "textile/camera_rig.hpp"
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+namespace textile {
+
+CameraRig::CameraRig(const std::string& name)
+    : name_(name), position_(0.), time_(0.), speed_(0.), started_(false) {}
+
+int CameraRig::AddCamera(const std::string& camera, double across,
+                         double along) {
+  Member member;
+  member.camera = camera;
+  member.across = across;
+  member.along = along;
+  member.width = 0.;
+  cameras_.push_back(member);
+  return static_cast<int>(cameras_.size()) - 1;
+}
+
+void CameraRig::SetWidth(int i, double width) {
+  CHECK_GE(width, 0.) << cameras_[i].camera;
+  cameras_[i].width = width;
+}
+
+void CameraRig::Share(int i, double* start, double* end) const {
+  const Member& a = cameras_[i];
+  const double a_end = a.across + a.width;
+  *start = a.across;
+  *end = a_end;
+  for (size_t j = 0; j < cameras_.size(); ++j) {
+    const Member& b = cameras_[j];
+    const double b_end = b.across + b.width;
+    if (static_cast<int>(j) == i || b.width <= 0. || b_end <= a.across ||
+        b.across >= a_end) {
+      continue;
+    }
+    // The middle of the overlap; of two cameras starting at the same place
+    // the first one added takes the left half.
+    const double middle = 0.5 * (std::max(a.across, b.across) +
+                                 std::min(a_end, b_end));
+    if (b.across < a.across ||
+        (b.across == a.across && static_cast<int>(j) < i)) {
+      *start = std::max(*start, middle);
+    } else {
+      *end = std::min(*end, middle);
+    }
+  }
+  *end = std::max(*end, *start);
+}
+
+void CameraRig::Advance(double time, double metres_per_second) {
+  if (started_) {
+    position_ = PositionAt(time);
+  }
+  time_ = time;
+  speed_ = metres_per_second;
+  started_ = true;
+}
+
+double CameraRig::PositionAt(double time) const {
+  return started_ ? position_ + speed_ * (time - time_) : 0.;
+}
+
+}  // namespace textile
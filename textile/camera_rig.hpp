@@ -0,0 +1,71 @@
+// Cameras side by side over one wide fabric.
+//
+// A wide loom is watched by several cameras, each seeing a strip of the
+// fabric that overlaps its neighbours'. The rig is calibrated by where the
+// roi of each camera starts in a shared fabric frame: metres across the
+// fabric and, for cameras mounted staggered, metres along it.
+//
+// Every overlap is split at its middle between the two cameras seeing it,
+// so each piece of the fabric is inspected by one camera only (Share). The
+// fabric position is kept on the rig's own clock and read at the capture
+// time of each frame, so frames read at slightly different times still
+// land at the right place. Mapped to the shared frame, the sightings of a
+// defect by two cameras -- one straddling a seam -- merge in a DefectMap
+// (see defect_map.hpp) like repeat sightings by one camera do.
+//
+#ifndef TEXTILE_CAMERA_RIG_HPP_
+#define TEXTILE_CAMERA_RIG_HPP_
+
+#include <string>
+#include <vector>
+
+namespace textile {
+
+class CameraRig {
+ public:
+  explicit CameraRig(const std::string& name);
+
+  /* Add a camera whose roi starts across metres from the origin of the rig
+   * and sees the fabric along metres downstream of it. Returns its index
+   * in the rig. */
+  int AddCamera(const std::string& camera, double across, double along);
+  /* Camera i shows width metres across the fabric; until this is known it
+   * overlaps no other. */
+  void SetWidth(int i, double width);
+
+  /* The part [start, end) of the rig, in metres across, camera i is to
+   * inspect. */
+  void Share(int i, double* start, double* end) const;
+
+  /* The fabric moves at metres_per_second from time (seconds, on any
+   * monotonic clock) on. */
+  void Advance(double time, double metres_per_second);
+  /* Metres of fabric moved past the rig at time. */
+  double PositionAt(double time) const;
+
+  const std::string& name() const { return name_; }
+  int num_cameras() const { return static_cast<int>(cameras_.size()); }
+  const std::string& camera(int i) const { return cameras_[i].camera; }
+  double across(int i) const { return cameras_[i].across; }
+  double along(int i) const { return cameras_[i].along; }
+
+ private:
+  struct Member {
+    std::string camera;
+    double across;
+    double along;
+    double width;
+  };
+
+  std::string name_;
+  std::vector<Member> cameras_;
+  /* Position at time_, and the speed since. */
+  double position_;
+  double time_;
+  double speed_;
+  bool started_;
+};
+
+}  // namespace textile
+
+#endif  // TEXTILE_CAMERA_RIG_HPP_
@@ -0,0 +1,107 @@
+#include "textile/clock_pattern.hpp"
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+namespace textile {
+
+static const int kGuardCells = 2;
+static const int kChecksumBits = 8;
+static const int kCells = kGuardCells + kClockPatternBits + kChecksumBits;
+static const int64_t kClockMask = (int64_t(1) << kClockPatternBits) - 1;
+/* Least white - black difference of the guards for a pattern to count. */
+static const double kMinContrast = 40.;
+
+static int Checksum(int64_t time_ms) {
+  int sum = 0;
+  for (int i = 0; i < kClockPatternBits; i += 8) {
+    sum += static_cast<int>((time_ms >> i) & 0xff);
+  }
+  return sum & 0xff;
+}
+
+/* Value of cell i of kCells: 1 is white. */
+static int CellValue(int64_t time_ms, int checksum, int i) {
+  if (i < kGuardCells) {
+    return i == 0 ? 1 : 0;
+  }
+  i -= kGuardCells;
+  if (i < kClockPatternBits) {
+    return static_cast<int>((time_ms >> (kClockPatternBits - 1 - i)) & 1);
+  }
+  i -= kClockPatternBits;
+  return (checksum >> (kChecksumBits - 1 - i)) & 1;
+}
+
+static cv::Rect Cell(const cv::Size& size, int i) {
+  const int x0 = static_cast<int>(static_cast<int64_t>(size.width) * i /
+                                  kCells);
+  const int x1 = static_cast<int>(static_cast<int64_t>(size.width) *
+                                  (i + 1) / kCells);
+  return cv::Rect(x0, 0, x1 - x0, size.height);
+}
+
+void DrawClockPattern(int64_t time_ms, cv::Mat* img) {
+  CHECK_GE(img->cols, kCells) << "Clock pattern too narrow";
+  time_ms &= kClockMask;
+  const int checksum = Checksum(time_ms);
+  for (int i = 0; i < kCells; ++i) {
+    const int value = CellValue(time_ms, checksum, i) ? 255 : 0;
+    (*img)(Cell(img->size(), i)).setTo(cv::Scalar(value, value, value));
+  }
+}
+
+bool ReadClockPattern(const cv::Mat& img, int64_t* time_ms) {
+  if (img.cols < kCells || img.rows < 1) {
+    return false;
+  }
+  cv::Mat gray;
+  if (img.channels() == 3) {
+    cv::cvtColor(img, gray, cv::COLOR_BGR2GRAY);
+  } else if (img.channels() == 4) {
+    cv::cvtColor(img, gray, cv::COLOR_BGRA2GRAY);
+  } else {
+    gray = img;
+  }
+  // Sample the middle half of each cell, away from blurred edges.
+  double level[kCells];
+  for (int i = 0; i < kCells; ++i) {
+    const cv::Rect cell = Cell(gray.size(), i);
+    const cv::Rect middle(cell.x + cell.width / 4, cell.height / 4,
+                          std::max(cell.width / 2, 1),
+                          std::max(cell.height / 2, 1));
+    level[i] = cv::mean(gray(middle))[0];
+  }
+  if (level[0] - level[1] < kMinContrast) {
+    return false;
+  }
+  const double threshold = 0.5 * (level[0] + level[1]);
+  int64_t value = 0;
+  for (int i = 0; i < kClockPatternBits; ++i) {
+    value = (value << 1) | (level[kGuardCells + i] > threshold ? 1 : 0);
+  }
+  int checksum = 0;
+  for (int i = 0; i < kChecksumBits; ++i) {
+    checksum = (checksum << 1) |
+        (level[kGuardCells + kClockPatternBits + i] > threshold ? 1 : 0);
+  }
+  if (checksum != Checksum(value)) {
+    return false;
+  }
+  *time_ms = value;
+  return true;
+}
+
+int64_t ClockPatternAge(int64_t now_ms, int64_t pattern_ms) {
+  int64_t age = ((now_ms & kClockMask) - pattern_ms) & kClockMask;
+  // A pattern slightly ahead (clock skew) wraps to a huge age.
+  if (age > kClockMask / 2) {
+    age -= kClockMask + 1;
+  }
+  return age;
+}
+
+}  // namespace textile
@@ -0,0 +1,35 @@
+// Machine-readable clock test pattern for measuring capture latency.
+//
+// A pattern is one row of equal-width cells across the image: a white and a
+// black guard cell, 40 bits of the wall clock in milliseconds (most
+// significant first, white is 1) and an 8-bit checksum of those. Shown on a
+// screen a camera films, or drawn into the frames of a replay server, it
+// lets a reader tell when each captured frame was on the glass; a frame
+// caught mid-update fails the checksum instead of giving a wrong time.
+//
+#ifndef TEXTILE_CLOCK_PATTERN_HPP_
+#define TEXTILE_CLOCK_PATTERN_HPP_
+
+#include <stdint.h>
+
+#include <opencv2/core/core.hpp>
+
+namespace textile {
+
+/* Bits of the clock in a pattern; times are compared modulo 2^40 ms. */
+static const int kClockPatternBits = 40;
+
+/* Fill img (8-bit gray or BGR, at least 50 pixels wide) with the pattern
+ * of time_ms. */
+void DrawClockPattern(int64_t time_ms, cv::Mat* img);
+
+/* Read the pattern filling img (8-bit gray, BGR or BGRA). Returns false if
+ * there is none or it does not check out. */
+bool ReadClockPattern(const cv::Mat& img, int64_t* time_ms);
+
+/* now_ms - pattern_ms, for a pattern_ms read by ReadClockPattern. */
+int64_t ClockPatternAge(int64_t now_ms, int64_t pattern_ms);
+
+}  // namespace textile
+
+#endif  // TEXTILE_CLOCK_PATTERN_HPP_
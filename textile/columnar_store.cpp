@@ -0,0 +1,386 @@
+#include "textile/columnar_store.hpp"
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <glog/logging.h>
+
+namespace textile {
+
+static const char kSegmentMagic[8] =
+    {'T', 'X', 'S', 'E', 'G', '0', '1', '\n'};
+
+static const size_t kColumnSize[kNumSegmentColumns] = {
+  sizeof(int64_t), sizeof(int64_t), sizeof(int32_t), sizeof(int32_t),
+  sizeof(float), sizeof(float), sizeof(float), sizeof(float), sizeof(float)
+};
+
+std::string LocalDay(int64_t time_ms) {
+  const time_t t = static_cast<time_t>(time_ms / 1000);
+  struct tm tm;
+  localtime_r(&t, &tm);
+  char day[16];
+  strftime(day, sizeof(day), "%Y-%m-%d", &tm);
+  return day;
+}
+
+/* Camera names become directory names. */
+static std::string PartitionName(const std::string& camera) {
+  std::string name = camera.empty() ? "_" : camera;
+  for (size_t i = 0; i < name.size(); ++i) {
+    if (name[i] == '/' || (i == 0 && name[i] == '.')) {
+      name[i] = '_';
+    }
+  }
+  return name;
+}
+
+static bool MakeDirs(const std::string& path) {
+  for (size_t pos = 1; pos <= path.size(); ++pos) {
+    if (pos == path.size() || path[pos] == '/') {
+      const std::string dir = path.substr(0, pos);
+      if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+static std::vector<std::string> ListDir(const std::string& path) {
+  std::vector<std::string> names;
+  DIR* dir = opendir(path.c_str());
+  if (dir == NULL) {
+    return names;
+  }
+  while (struct dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') {
+      names.push_back(entry->d_name);
+    }
+  }
+  closedir(dir);
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+template <typename T>
+static bool WriteColumn(const std::vector<T>& column, FILE* f) {
+  return column.empty() ||
+      fwrite(&column[0], sizeof(T), column.size(), f) == column.size();
+}
+
+ColumnarSink::ColumnarSink(const std::string& root, int segment_rows,
+                           int max_age_seconds)
+    : root_(root), segment_rows_(segment_rows),
+      max_age_ms_(static_cast<int64_t>(max_age_seconds) * 1000),
+      sequence_(0) {
+  CHECK_GT(segment_rows_, 0);
+  CHECK(MakeDirs(root_)) << "Unable to create " << root_;
+}
+
+ColumnarSink::~ColumnarSink() {
+  Flush();
+}
+
+void ColumnarSink::Write(const std::vector<DetectionRecord>& records) {
+  for (size_t i = 0; i < records.size(); ++i) {
+    const DetectionRecord& r = records[i];
+    const std::string day = LocalDay(r.time_ms);
+    const std::string camera = PartitionName(r.camera);
+    Partition& p = partitions_[day + "/" + camera];
+    if (p.time_ms.empty()) {
+      p.dir = root_ + "/" + day + "/" + camera;
+      p.opened_ms = WallTimeMs();
+    }
+    int32_t model = std::find(p.models.begin(), p.models.end(), r.model) -
+        p.models.begin();
+    if (model == static_cast<int32_t>(p.models.size())) {
+      p.models.push_back(r.model);
+    }
+    p.time_ms.push_back(r.time_ms);
+    p.frame.push_back(r.frame);
+    p.model.push_back(model);
+    p.label.push_back(r.label);
+    p.score.push_back(r.score);
+    p.xmin.push_back(r.xmin);
+    p.ymin.push_back(r.ymin);
+    p.xmax.push_back(r.xmax);
+    p.ymax.push_back(r.ymax);
+    if (static_cast<int>(p.time_ms.size()) >= segment_rows_) {
+      Seal(&p);
+    }
+  }
+
+  // Seal partitions that have been open too long, which also retires
+  // those of a day that has ended.
+  const int64_t now = WallTimeMs();
+  for (std::map<std::string, Partition>::iterator it = partitions_.begin();
+       it != partitions_.end();) {
+    if (!it->second.time_ms.empty() &&
+        now - it->second.opened_ms >= max_age_ms_) {
+      Seal(&it->second);
+    }
+    if (it->second.time_ms.empty()) {
+      partitions_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void ColumnarSink::Flush() {
+  for (std::map<std::string, Partition>::iterator it = partitions_.begin();
+       it != partitions_.end(); ++it) {
+    if (!it->second.time_ms.empty()) {
+      Seal(&it->second);
+    }
+  }
+  partitions_.clear();
+}
+
+void ColumnarSink::Seal(Partition* p) {
+  SegmentHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kSegmentMagic, sizeof(header.magic));
+  header.rows = static_cast<uint32_t>(p->time_ms.size());
+  header.num_models = static_cast<uint32_t>(p->models.size());
+  header.min_time_ms =
+      *std::min_element(p->time_ms.begin(), p->time_ms.end());
+  header.max_time_ms =
+      *std::max_element(p->time_ms.begin(), p->time_ms.end());
+  header.min_label = *std::min_element(p->label.begin(), p->label.end());
+  header.max_label = *std::max_element(p->label.begin(), p->label.end());
+  header.min_score = *std::min_element(p->score.begin(), p->score.end());
+  header.max_score = *std::max_element(p->score.begin(), p->score.end());
+
+  char name[64];
+  snprintf(name, sizeof(name), "/%lld-%lld.seg",
+           static_cast<long long>(header.min_time_ms),
+           static_cast<long long>(sequence_++));
+  const std::string path = p->dir + name;
+  const std::string tmp_path = path + ".tmp";
+  bool ok = MakeDirs(p->dir);
+  FILE* f = ok ? fopen(tmp_path.c_str(), "wb") : NULL;
+  ok = f != NULL && fwrite(&header, sizeof(header), 1, f) == 1;
+  for (size_t i = 0; ok && i < p->models.size(); ++i) {
+    const uint32_t length = static_cast<uint32_t>(p->models[i].size());
+    ok = fwrite(&length, sizeof(length), 1, f) == 1 &&
+        fwrite(p->models[i].data(), 1, length, f) == length;
+  }
+  ok = ok && WriteColumn(p->time_ms, f) && WriteColumn(p->frame, f) &&
+      WriteColumn(p->model, f) && WriteColumn(p->label, f) &&
+      WriteColumn(p->score, f) && WriteColumn(p->xmin, f) &&
+      WriteColumn(p->ymin, f) && WriteColumn(p->xmax, f) &&
+      WriteColumn(p->ymax, f);
+  if (f != NULL) {
+    ok = fclose(f) == 0 && ok;
+  }
+  // Readers only ever see complete segments.
+  if (ok && rename(tmp_path.c_str(), path.c_str()) == 0) {
+    VLOG(1) << "Wrote " << header.rows << " detections to " << path;
+  } else {
+    LOG(WARNING) << "Failed to write segment " << path << ", dropping "
+                 << header.rows << " detections";
+    remove(tmp_path.c_str());
+  }
+
+  p->models.clear();
+  p->time_ms.clear();
+  p->frame.clear();
+  p->model.clear();
+  p->label.clear();
+  p->score.clear();
+  p->xmin.clear();
+  p->ymin.clear();
+  p->xmax.clear();
+  p->ymax.clear();
+}
+
+template <typename T>
+static bool ReadColumn(FILE* f, long offset, uint32_t rows,
+                       std::vector<T>* column) {
+  column->resize(rows);
+  return fseek(f, offset, SEEK_SET) == 0 &&
+      (rows == 0 || fread(&(*column)[0], sizeof(T), rows, f) == rows);
+}
+
+/* Fill rows from the segment at path, or return false when it cannot be
+ * read or its index rules the filter out. */
+static bool ReadSegment(const std::string& path, const ScanFilter& filter,
+                        unsigned columns, SegmentRows* rows,
+                        ScanStats* stats) {
+  FILE* f = fopen(path.c_str(), "rb");
+  if (f == NULL) {
+    return false;
+  }
+  SegmentHeader& h = rows->header;
+  bool ok = fread(&h, sizeof(h), 1, f) == 1 &&
+      memcmp(h.magic, kSegmentMagic, sizeof(h.magic)) == 0;
+  if (!ok) {
+    LOG(WARNING) << "Not a segment: " << path;
+    fclose(f);
+    return false;
+  }
+  if (h.max_time_ms < filter.from_ms || h.min_time_ms >= filter.to_ms ||
+      (filter.label >= 0 &&
+       (filter.label < h.min_label || filter.label > h.max_label)) ||
+      h.max_score < filter.min_score) {
+    fclose(f);
+    return false;
+  }
+
+  rows->models.resize(h.num_models);
+  int32_t wanted_model = -1;
+  for (uint32_t i = 0; ok && i < h.num_models; ++i) {
+    uint32_t length = 0;
+    ok = fread(&length, sizeof(length), 1, f) == 1 && length < 4096;
+    if (ok) {
+      rows->models[i].resize(length);
+      ok = length == 0 ||
+          fread(&rows->models[i][0], 1, length, f) == length;
+    }
+    if (ok && rows->models[i] == filter.model) {
+      wanted_model = static_cast<int32_t>(i);
+    }
+  }
+  if (!ok || (!filter.model.empty() && wanted_model < 0)) {
+    fclose(f);
+    return false;
+  }
+  ++stats->segments_read;
+
+  // Columns the filter needs come on top of the requested ones.
+  if (filter.from_ms != ScanFilter().from_ms ||
+      filter.to_ms != ScanFilter().to_ms) {
+    columns |= 1u << kColTime;
+  }
+  if (!filter.model.empty()) columns |= 1u << kColModel;
+  if (filter.label >= 0) columns |= 1u << kColLabel;
+  if (filter.min_score > 0.f) columns |= 1u << kColScore;
+
+  long offset = ftell(f);
+  const uint32_t n = h.rows;
+  for (int c = 0; ok && c < kNumSegmentColumns; ++c) {
+    if (columns & (1u << c)) {
+      switch (c) {
+        case kColTime: ok = ReadColumn(f, offset, n, &rows->time_ms); break;
+        case kColFrame: ok = ReadColumn(f, offset, n, &rows->frame); break;
+        case kColModel: ok = ReadColumn(f, offset, n, &rows->model); break;
+        case kColLabel: ok = ReadColumn(f, offset, n, &rows->label); break;
+        case kColScore: ok = ReadColumn(f, offset, n, &rows->score); break;
+        case kColXmin: ok = ReadColumn(f, offset, n, &rows->xmin); break;
+        case kColYmin: ok = ReadColumn(f, offset, n, &rows->ymin); break;
+        case kColXmax: ok = ReadColumn(f, offset, n, &rows->xmax); break;
+        case kColYmax: ok = ReadColumn(f, offset, n, &rows->ymax); break;
+      }
+    }
+    offset += static_cast<long>(kColumnSize[c] * n);
+  }
+  fclose(f);
+  if (!ok) {
+    LOG(WARNING) << "Truncated segment: " << path;
+    return false;
+  }
+  stats->rows_read += n;
+
+  // Evaluate the filter one column at a time; the loops are branch-free so
+  // that the compiler vectorizes them.
+  std::vector<uint8_t>& sel = rows->selected;
+  sel.assign(n, 1);
+  if (columns & (1u << kColTime)) {
+    const int64_t* t = rows->time_ms.data();
+    const int64_t from = filter.from_ms;
+    const int64_t to = filter.to_ms;
+    for (uint32_t i = 0; i < n; ++i) {
+      sel[i] &= (t[i] >= from) & (t[i] < to);
+    }
+  }
+  if (!filter.model.empty()) {
+    const int32_t* m = rows->model.data();
+    for (uint32_t i = 0; i < n; ++i) {
+      sel[i] &= m[i] == wanted_model;
+    }
+  }
+  if (filter.label >= 0) {
+    const int32_t* l = rows->label.data();
+    const int32_t label = filter.label;
+    for (uint32_t i = 0; i < n; ++i) {
+      sel[i] &= l[i] == label;
+    }
+  }
+  if (filter.min_score > 0.f) {
+    const float* s = rows->score.data();
+    const float min_score = filter.min_score;
+    for (uint32_t i = 0; i < n; ++i) {
+      sel[i] &= s[i] >= min_score;
+    }
+  }
+  int64_t selected = 0;
+  for (uint32_t i = 0; i < n; ++i) {
+    selected += sel[i];
+  }
+  stats->rows_selected += selected;
+  return selected > 0;
+}
+
+bool ScanStore(const std::string& root, const ScanFilter& filter,
+               unsigned columns, SegmentVisitor* visitor, ScanStats* stats) {
+  DIR* dir = opendir(root.c_str());
+  if (dir == NULL) {
+    return false;
+  }
+  closedir(dir);
+
+  // Day partitions compare as strings; the local days of the bounds limit
+  // the directories visited.
+  const ScanFilter all;
+  const std::string first_day =
+      filter.from_ms == all.from_ms ? "" : LocalDay(filter.from_ms);
+  const std::string last_day =
+      filter.to_ms == all.to_ms ? "~" : LocalDay(filter.to_ms - 1);
+  std::vector<std::string> cameras;
+  for (size_t i = 0; i < filter.cameras.size(); ++i) {
+    cameras.push_back(PartitionName(filter.cameras[i]));
+  }
+
+  SegmentRows rows;
+  const std::vector<std::string> days = ListDir(root);
+  for (size_t d = 0; d < days.size(); ++d) {
+    if (days[d] < first_day || days[d] > last_day) {
+      continue;
+    }
+    const std::string day_dir = root + "/" + days[d];
+    const std::vector<std::string> partitions = ListDir(day_dir);
+    for (size_t p = 0; p < partitions.size(); ++p) {
+      if (!cameras.empty() && std::find(cameras.begin(), cameras.end(),
+                                        partitions[p]) == cameras.end()) {
+        continue;
+      }
+      const std::string camera_dir = day_dir + "/" + partitions[p];
+      const std::vector<std::string> segments = ListDir(camera_dir);
+      for (size_t s = 0; s < segments.size(); ++s) {
+        const std::string& name = segments[s];
+        if (name.size() < 4 || name.compare(name.size() - 4, 4, ".seg")) {
+          continue;
+        }
+        ++stats->segments;
+        rows.path = camera_dir + "/" + name;
+        rows.camera = partitions[p];
+        if (ReadSegment(rows.path, filter, columns, &rows, stats)) {
+          visitor->Visit(rows);
+        }
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace textile
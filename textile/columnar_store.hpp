@@ -0,0 +1,161 @@
+// Append-only columnar store of detections.
+//
+// Detections are partitioned by local day and camera:
+//    <root>/<YYYY-MM-DD>/<camera>/<min time_ms>-<seq>.seg
+// Each segment is immutable once written. It starts with a fixed header
+// that doubles as its index (row count and min/max of time, label and
+// score), followed by the model name dictionary and one contiguous array
+// per column, all in host (little-endian) byte order:
+//
+//    SegmentHeader
+//    num_models x { uint32 length, bytes }
+//    int64 time_ms[rows]   int64 frame[rows]   int32 model[rows]
+//    int32 label[rows]     float score[rows]
+//    float xmin[rows]  float ymin[rows]  float xmax[rows]  float ymax[rows]
+//
+// A query reads the headers, skips segments whose index excludes the
+// filter, reads only the columns it needs from the rest and evaluates the
+// filter over whole columns at once.
+//
+#ifndef TEXTILE_COLUMNAR_STORE_HPP_
+#define TEXTILE_COLUMNAR_STORE_HPP_
+
+#include <stdint.h>
+
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "textile/detection_sink.hpp"
+
+namespace textile {
+
+struct SegmentHeader {
+  char magic[8];
+  uint32_t rows;
+  uint32_t num_models;
+  int64_t min_time_ms;
+  int64_t max_time_ms;
+  int32_t min_label;
+  int32_t max_label;
+  float min_score;
+  float max_score;
+};
+
+enum SegmentColumn {
+  kColTime = 0,
+  kColFrame,
+  kColModel,
+  kColLabel,
+  kColScore,
+  kColXmin,
+  kColYmin,
+  kColXmax,
+  kColYmax,
+  kNumSegmentColumns
+};
+
+/* Writes DetectionRecords into segments under root. A partition's rows are
+ * buffered until segment_rows of them are collected or the oldest is
+ * max_age_seconds old, whichever comes first. */
+class ColumnarSink : public DetectionSink {
+ public:
+  ColumnarSink(const std::string& root, int segment_rows,
+               int max_age_seconds);
+  virtual ~ColumnarSink();
+
+  virtual void Write(const std::vector<DetectionRecord>& records);
+  virtual void Flush();
+
+ private:
+  struct Partition {
+    std::string dir;
+    int64_t opened_ms;
+    std::vector<std::string> models;
+    std::vector<int64_t> time_ms;
+    std::vector<int64_t> frame;
+    std::vector<int32_t> model;
+    std::vector<int32_t> label;
+    std::vector<float> score;
+    std::vector<float> xmin;
+    std::vector<float> ymin;
+    std::vector<float> xmax;
+    std::vector<float> ymax;
+  };
+
+  /* Write p out as a segment and empty it. */
+  void Seal(Partition* p);
+
+  std::string root_;
+  int segment_rows_;
+  int64_t max_age_ms_;
+  int64_t sequence_;
+  /* Keyed by "<day>/<camera>". */
+  std::map<std::string, Partition> partitions_;
+};
+
+/* What a scan selects; empty or negative fields match everything. */
+struct ScanFilter {
+  ScanFilter()
+      : from_ms(std::numeric_limits<int64_t>::min()),
+        to_ms(std::numeric_limits<int64_t>::max()),
+        label(-1), min_score(0.f) {}
+
+  int64_t from_ms;  // inclusive
+  int64_t to_ms;    // exclusive
+  std::vector<std::string> cameras;
+  std::string model;
+  int label;
+  float min_score;
+};
+
+/* The rows of one segment that passed a filter. Only the columns asked
+ * for are loaded; the others are empty. */
+struct SegmentRows {
+  std::string path;
+  std::string camera;
+  SegmentHeader header;
+  std::vector<std::string> models;
+  std::vector<int64_t> time_ms;
+  std::vector<int64_t> frame;
+  std::vector<int32_t> model;
+  std::vector<int32_t> label;
+  std::vector<float> score;
+  std::vector<float> xmin;
+  std::vector<float> ymin;
+  std::vector<float> xmax;
+  std::vector<float> ymax;
+  /* selected[i] != 0 for the rows that match. */
+  std::vector<uint8_t> selected;
+};
+
+struct ScanStats {
+  ScanStats() : segments(0), segments_read(0), rows_read(0),
+                rows_selected(0) {}
+
+  int64_t segments;       // segments in the partitions visited
+  int64_t segments_read;  // segments whose index did not exclude them
+  int64_t rows_read;
+  int64_t rows_selected;
+};
+
+/* Called once per segment that has selected rows. */
+class SegmentVisitor {
+ public:
+  virtual ~SegmentVisitor() {}
+  virtual void Visit(const SegmentRows& rows) = 0;
+};
+
+/* Scan the store at root. columns is a bit mask of (1 << SegmentColumn)
+ * the visitor needs beyond those of the filter. Returns false if root
+ * cannot be read. */
+bool ScanStore(const std::string& root, const ScanFilter& filter,
+               unsigned columns, SegmentVisitor* visitor, ScanStats* stats);
+
+/* Local calendar day of time_ms as YYYY-MM-DD. */
+std::string LocalDay(int64_t time_ms);
+
+}  // namespace textile
+
+#endif  // TEXTILE_COLUMNAR_STORE_HPP_
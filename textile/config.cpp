@@ -0,0 +1,515 @@
+#include "textile/config.hpp"
+
+#include <ctype.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <glog/logging.h>
+
+namespace textile {
+
+static std::string Trim(const std::string& s) {
+  const size_t begin = s.find_first_not_of(" \t\r");
+  if (begin == std::string::npos) {
+    return std::string();
+  }
+  const size_t end = s.find_last_not_of(" \t\r");
+  return s.substr(begin, end - begin + 1);
+}
+
+static bool ParseFloat(const std::string& value, float* out) {
+  char* end = NULL;
+  const double parsed = strtod(value.c_str(), &end);
+  if (value.empty() || *end != '\0') {
+    return false;
+  }
+  *out = static_cast<float>(parsed);
+  return true;
+}
+
+static bool ParseInt(const std::string& value, int* out) {
+  char* end = NULL;
+  const long parsed = strtol(value.c_str(), &end, 10);
+  if (value.empty() || *end != '\0') {
+    return false;
+  }
+  *out = static_cast<int>(parsed);
+  return true;
+}
+
+static bool ParseRoi(const std::string& value, Roi* roi) {
+  if (value.empty()) {
+    *roi = Roi();
+    return true;
+  }
+  std::stringstream ss(value);
+  std::string item;
+  std::vector<int> fields;
+  while (getline(ss, item, ',')) {
+    int field;
+    if (!ParseInt(Trim(item), &field)) {
+      return false;
+    }
+    fields.push_back(field);
+  }
+  if (fields.size() != 4) {
+    return false;
+  }
+  roi->x = fields[0];
+  roi->y = fields[1];
+  roi->width = fields[2];
+  roi->height = fields[3];
+  return true;
+}
+
+static bool ParseBool(const std::string& value, bool* out) {
+  if (value == "true" || value == "yes" || value == "1") {
+    *out = true;
+  } else if (value == "false" || value == "no" || value == "0") {
+    *out = false;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/* "<width>x<height>"; empty is 0x0. */
+static bool ParseSize(const std::string& value, int* width, int* height) {
+  if (value.empty()) {
+    *width = 0;
+    *height = 0;
+    return true;
+  }
+  const size_t x = value.find('x');
+  return x != std::string::npos &&
+      ParseInt(Trim(value.substr(0, x)), width) &&
+      ParseInt(Trim(value.substr(x + 1)), height) &&
+      *width > 0 && *height > 0;
+}
+
+static bool HigherPriority(const CameraConfig& a, const CameraConfig& b) {
+  return a.priority > b.priority;
+}
+
+namespace {
+
+/* Collects problems with their line numbers. */
+class ErrorList {
+ public:
+  ErrorList() : line_(0) {}
+
+  void set_line(int line) { line_ = line; }
+
+  void Add(const std::string& message) {
+    std::ostringstream ss;
+    if (line_ > 0) {
+      ss << "line " << line_ << ": ";
+    }
+    ss << message;
+    errors_.push_back(ss.str());
+  }
+
+  bool empty() const { return errors_.empty(); }
+
+  std::string ToString() const {
+    std::string out;
+    for (size_t i = 0; i < errors_.size(); ++i) {
+      out += errors_[i] + "\n";
+    }
+    return out;
+  }
+
+ private:
+  int line_;
+  std::vector<std::string> errors_;
+};
+
+}  // namespace
+
+static void SetGlobal(const std::string& key, const std::string& value,
+                      Config* config, ErrorList* errors) {
+  if (key == "threshold") {
+    if (!ParseFloat(value, &config->threshold)) {
+      errors->Add("threshold is not a number: " + value);
+    }
+  } else if (key == "type") {
+    config->type = value;
+  } else if (key == "model") {
+    config->model_file = value;
+  } else if (key == "data") {
+    config->weights_file = value;
+  } else if (key == "mean_file") {
+    config->mean_file = value;
+  } else if (key == "mean_value") {
+    config->mean_value = value;
+  } else if (key == "listfile") {
+    config->list_file = value;
+  } else {
+    errors->Add("unknown key: " + key);
+  }
+}
+
+static void SetCamera(const std::string& key, const std::string& value,
+                      CameraConfig* camera, ErrorList* errors) {
+  if (key == "url") {
+    camera->url = value;
+  } else if (key == "username") {
+    camera->username = value;
+  } else if (key == "password") {
+    camera->password = value;
+  } else if (key == "ip") {
+    camera->ip = value;
+  } else if (key == "path") {
+    camera->path = value;
+  } else if (key == "roi") {
+    if (!ParseRoi(value, &camera->roi)) {
+      errors->Add("roi must be x,y,width,height: " + value);
+    }
+  } else if (key == "threshold") {
+    if (!ParseFloat(value, &camera->threshold)) {
+      errors->Add("threshold is not a number: " + value);
+    }
+  } else if (key == "sample_every") {
+    if (!ParseInt(value, &camera->sample_every)) {
+      errors->Add("sample_every is not an integer: " + value);
+    }
+  } else if (key == "priority") {
+    if (!ParseInt(value, &camera->priority)) {
+      errors->Add("priority is not an integer: " + value);
+    }
+  } else if (key == "fabric_speed") {
+    if (!ParseFloat(value, &camera->fabric_speed)) {
+      errors->Add("fabric_speed is not a number: " + value);
+    }
+  } else if (key == "pixels_per_metre") {
+    if (!ParseFloat(value, &camera->pixels_per_metre)) {
+      errors->Add("pixels_per_metre is not a number: " + value);
+    }
+  } else if (key == "fabric_axis") {
+    camera->fabric_axis = value;
+  } else if (key == "fov_length") {
+    if (!ParseFloat(value, &camera->fov_length)) {
+      errors->Add("fov_length is not a number: " + value);
+    }
+  } else if (key == "overlap") {
+    if (!ParseFloat(value, &camera->overlap)) {
+      errors->Add("overlap is not a number: " + value);
+    }
+  } else if (key == "rig") {
+    camera->rig = value;
+  } else if (key == "rig_across") {
+    if (!ParseFloat(value, &camera->rig_across)) {
+      errors->Add("rig_across is not a number: " + value);
+    }
+  } else if (key == "rig_along") {
+    if (!ParseFloat(value, &camera->rig_along)) {
+      errors->Add("rig_along is not a number: " + value);
+    }
+  } else if (key == "backend") {
+    camera->backend = value;
+  } else if (key == "codec") {
+    camera->codec = value;
+  } else if (key == "latency_ms") {
+    if (!ParseInt(value, &camera->latency_ms)) {
+      errors->Add("latency_ms is not an integer: " + value);
+    }
+  } else if (key == "drop") {
+    camera->drop = value;
+  } else if (key == "scale") {
+    if (!ParseSize(value, &camera->scale_width, &camera->scale_height)) {
+      errors->Add("scale must be <width>x<height>: " + value);
+    }
+  } else if (key == "transport") {
+    camera->transport = value;
+  } else if (key == "probe_size") {
+    if (!ParseInt(value, &camera->probe_size)) {
+      errors->Add("probe_size is not an integer: " + value);
+    }
+  } else if (key == "analyze_duration_ms") {
+    if (!ParseInt(value, &camera->analyze_duration_ms)) {
+      errors->Add("analyze_duration_ms is not an integer: " + value);
+    }
+  } else if (key == "max_delay_ms") {
+    if (!ParseInt(value, &camera->max_delay_ms)) {
+      errors->Add("max_delay_ms is not an integer: " + value);
+    }
+  } else if (key == "reorder_queue") {
+    if (!ParseInt(value, &camera->reorder_queue)) {
+      errors->Add("reorder_queue is not an integer: " + value);
+    }
+  } else if (key == "low_delay") {
+    if (!ParseBool(value, &camera->low_delay)) {
+      errors->Add("low_delay must be true or false: " + value);
+    }
+  } else if (key == "ntp_timestamps") {
+    if (!ParseBool(value, &camera->ntp_timestamps)) {
+      errors->Add("ntp_timestamps must be true or false: " + value);
+    }
+  } else {
+    errors->Add("unknown camera key: " + key);
+  }
+}
+
+static void SetModel(const std::string& key, const std::string& value,
+                     ModelConfig* model, ErrorList* errors) {
+  if (key == "model") {
+    model->model_file = value;
+  } else if (key == "data") {
+    model->weights_file = value;
+  } else if (key == "mean_file") {
+    model->mean_file = value;
+  } else if (key == "mean_value") {
+    model->mean_value = value;
+  } else if (key == "threshold") {
+    if (!ParseFloat(value, &model->threshold)) {
+      errors->Add("threshold is not a number: " + value);
+    }
+  } else {
+    errors->Add("unknown model key: " + key);
+  }
+}
+
+/* Checks that need the whole file, and defaults derived from it. */
+static void Validate(Config* config, ErrorList* errors) {
+  errors->set_line(0);
+  if (config->type != "image" && config->type != "video" &&
+      config->type != "rtsp") {
+    errors->Add("type must be image, video or rtsp: '" + config->type + "'");
+  }
+  if (config->model_file.empty()) {
+    errors->Add("model is required");
+  }
+  if (config->weights_file.empty()) {
+    errors->Add("data is required");
+  }
+  if (!config->mean_file.empty() && !config->mean_value.empty()) {
+    errors->Add("mean_file and mean_value are mutually exclusive");
+  }
+  if (config->threshold < 0.f || config->threshold > 1.f) {
+    errors->Add("threshold must be within [0, 1]");
+  }
+  if (config->type == "rtsp" && config->cameras.empty()) {
+    errors->Add("type rtsp needs at least one [camera] section");
+  }
+  if (config->type != "rtsp" && config->list_file.empty()) {
+    errors->Add("listfile is required for type " + config->type);
+  }
+
+  std::set<std::string> names;
+  for (size_t i = 0; i < config->cameras.size(); ++i) {
+    CameraConfig& camera = config->cameras[i];
+    const std::string where = "camera " + camera.name + ": ";
+    if (!names.insert(camera.name).second) {
+      errors->Add(where + "defined twice");
+    }
+    if (camera.url.empty()) {
+      if (camera.ip.empty()) {
+        errors->Add(where + "either url or ip is required");
+      } else {
+        camera.url = "rtsp://";
+        if (!camera.username.empty()) {
+          camera.url += camera.username + ":" + camera.password + "@";
+        }
+        camera.url += camera.ip +
+            (camera.path.empty() ? "/h264/ch1/sub/av_stream" : camera.path);
+      }
+    }
+    if (camera.threshold < 0.f) {
+      camera.threshold = config->threshold;
+    } else if (camera.threshold > 1.f) {
+      errors->Add(where + "threshold must be within [0, 1]");
+    }
+    if (camera.roi.x < 0 || camera.roi.y < 0 || camera.roi.width < 0 ||
+        camera.roi.height < 0) {
+      errors->Add(where + "roi must not be negative");
+    }
+    if (camera.sample_every < 1) {
+      errors->Add(where + "sample_every must be at least 1");
+    }
+    if (camera.fabric_speed < 0.f) {
+      errors->Add(where + "fabric_speed must not be negative");
+    }
+    if (camera.pixels_per_metre < 0.f) {
+      errors->Add(where + "pixels_per_metre must not be negative");
+    }
+    if (camera.fabric_axis != "x" && camera.fabric_axis != "y") {
+      errors->Add(where + "fabric_axis must be x or y: '" +
+                  camera.fabric_axis + "'");
+    }
+    if (camera.fov_length < 0.f) {
+      errors->Add(where + "fov_length must not be negative");
+    }
+    if (camera.overlap >= 1.f) {
+      errors->Add(where + "overlap must be below 1");
+    } else if (camera.overlap >= 0.f) {
+      if (camera.fabric_speed <= 0.f && camera.pixels_per_metre <= 0.f) {
+        errors->Add(where + "overlap needs a fabric_speed or a"
+                    " pixels_per_metre");
+      }
+      if (camera.fov_length <= 0.f && camera.pixels_per_metre <= 0.f) {
+        errors->Add(where + "overlap needs a fov_length or a"
+                    " pixels_per_metre");
+      }
+    }
+    if (!camera.rig.empty()) {
+      if (camera.fabric_speed <= 0.f && camera.pixels_per_metre <= 0.f) {
+        errors->Add(where + "rig needs a fabric_speed or a pixels_per_metre");
+      }
+      if (camera.fov_length <= 0.f && camera.pixels_per_metre <= 0.f) {
+        errors->Add(where + "rig needs a fov_length or a pixels_per_metre");
+      }
+    }
+    if (camera.backend != "opencv" && camera.backend != "gstreamer") {
+      errors->Add(where + "backend must be opencv or gstreamer: '" +
+                  camera.backend + "'");
+    }
+    if (camera.codec != "h264" && camera.codec != "h265") {
+      errors->Add(where + "codec must be h264 or h265: '" + camera.codec +
+                  "'");
+    }
+    if (camera.latency_ms < 0) {
+      errors->Add(where + "latency_ms must not be negative");
+    }
+    if (!camera.transport.empty() && camera.transport != "tcp" &&
+        camera.transport != "udp") {
+      errors->Add(where + "transport must be tcp or udp: '" +
+                  camera.transport + "'");
+    }
+    if (camera.drop != "latest" && camera.drop != "none") {
+      errors->Add(where + "drop must be latest or none: '" + camera.drop +
+                  "'");
+    }
+  }
+  std::stable_sort(config->cameras.begin(), config->cameras.end(),
+                   HigherPriority);
+
+  names.clear();
+  for (size_t i = 0; i < config->models.size(); ++i) {
+    ModelConfig& model = config->models[i];
+    const std::string where = "model " + model.name + ": ";
+    if (!names.insert(model.name).second) {
+      errors->Add(where + "defined twice");
+    }
+    if (model.model_file.empty()) {
+      errors->Add(where + "model is required");
+    }
+    if (model.weights_file.empty()) {
+      errors->Add(where + "data is required");
+    }
+    if (!model.mean_file.empty() && !model.mean_value.empty()) {
+      errors->Add(where + "mean_file and mean_value are mutually exclusive");
+    } else if (model.mean_file.empty() && model.mean_value.empty()) {
+      model.mean_file = config->mean_file;
+      model.mean_value = config->mean_value;
+    }
+    if (model.threshold > 1.f) {
+      errors->Add(where + "threshold must be within [0, 1]");
+    }
+  }
+}
+
+/* Cut line at a '#' that starts it or follows whitespace; elsewhere '#' is
+ * part of the value, as in URLs and passwords. */
+static void StripComment(std::string* line) {
+  for (size_t i = line->find('#'); i != std::string::npos;
+       i = line->find('#', i + 1)) {
+    if (i == 0 || isspace(static_cast<unsigned char>((*line)[i - 1]))) {
+      line->erase(i);
+      return;
+    }
+  }
+}
+
+bool ParseConfig(std::istream& in, Config* config, std::string* error) {
+  enum Section { kGlobal, kCamera, kModel } section = kGlobal;
+  std::set<std::string> seen;
+  ErrorList errors;
+  std::string line;
+  int line_number = 0;
+  while (getline(in, line)) {
+    errors.set_line(++line_number);
+    StripComment(&line);
+    line = Trim(line);
+    if (line.empty()) {
+      continue;
+    }
+
+    if (line[0] == '[') {
+      if (line[line.size() - 1] != ']') {
+        errors.Add("unterminated section header: " + line);
+        continue;
+      }
+      const std::string header = Trim(line.substr(1, line.size() - 2));
+      if (header.compare(0, 7, "camera ") == 0) {
+        section = kCamera;
+        config->cameras.push_back(CameraConfig());
+        config->cameras.back().name = Trim(header.substr(7));
+      } else if (header.compare(0, 6, "model ") == 0) {
+        section = kModel;
+        config->models.push_back(ModelConfig());
+        config->models.back().name = Trim(header.substr(6));
+      } else {
+        errors.Add("unknown section: " + header);
+        continue;
+      }
+      if (!seen.insert("[" + header + "]").second) {
+        errors.Add("duplicate section: " + header);
+      }
+      continue;
+    }
+
+    const size_t split_pos = line.find('=');
+    if (split_pos == std::string::npos) {
+      errors.Add("expected key = value: " + line);
+      continue;
+    }
+    const std::string key = Trim(line.substr(0, split_pos));
+    const std::string value = Trim(line.substr(split_pos + 1));
+    std::string scope;
+    if (section == kCamera) {
+      scope = "[camera]" + config->cameras.back().name;
+    } else if (section == kModel) {
+      scope = "[model]" + config->models.back().name;
+    }
+    if (!seen.insert(scope + "." + key).second) {
+      errors.Add("duplicate key: " + key);
+    }
+    switch (section) {
+      case kGlobal:
+        SetGlobal(key, value, config, &errors);
+        break;
+      case kCamera:
+        SetCamera(key, value, &config->cameras.back(), &errors);
+        break;
+      case kModel:
+        SetModel(key, value, &config->models.back(), &errors);
+        break;
+    }
+  }
+
+  Validate(config, &errors);
+  if (!errors.empty()) {
+    *error = errors.ToString();
+    return false;
+  }
+  return true;
+}
+
+std::shared_ptr<const Config> LoadConfigOrDie(const std::string& path) {
+  std::ifstream cfgfile(path.c_str());
+  CHECK(cfgfile.good()) << "Unable to open config file " << path;
+  std::shared_ptr<Config> config(new Config());
+  std::string error;
+  if (!ParseConfig(cfgfile, config.get(), &error)) {
+    LOG(FATAL) << "Invalid config file " << path << ":\n" << error;
+  }
+  return config;
+}
+
+}  // namespace textile
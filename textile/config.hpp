@@ -0,0 +1,182 @@
+// Typed configuration of the detector, parsed and validated once at load.
+//
+// The file is INI-like: global keys first, then one [camera <name>] section
+// per stream and one [model <name>] section per additional model. '#'
+// starts a comment at the start of a line or after whitespace; anywhere
+// else it is part of the value (a URL or password may contain one).
+//
+//    threshold = 0.6
+//    type = rtsp                  # image, video or rtsp
+//    model = /path/deploy.prototxt
+//    data = /path/weights.caffemodel
+//    listfile = /path/list.txt    # image and video types only
+//
+//    [camera loom1]
+//    username = admin
+//    password = secret
+//    ip = 192.168.0.102
+//    roi = 0,0,1280,720           # x,y,width,height; empty is the whole frame
+//    threshold = 0.5              # defaults to the global threshold
+//    sample_every = 2             # run the detector on every 2nd frame
+//    priority = 1                 # higher is served first
+//    fabric_speed = 30            # metres per minute; 0 if unknown
+//    pixels_per_metre = 1100      # of fabric in the frame; 0 disables the
+//                                 # speed estimate (see speed_estimator.hpp)
+//    fabric_axis = y              # the fabric moves along x or y
+//    fov_length = 0.9             # metres of fabric in the roi along
+//                                 # fabric_axis; 0 derives it from
+//                                 # pixels_per_metre
+//    overlap = 0.2                # with a fabric speed, inspect frames so
+//                                 # that consecutive ones share this much of
+//                                 # the view (see inspection_scheduler.hpp);
+//                                 # negative uses sample_every
+//    rig = loom3                  # cameras side by side over one fabric
+//    rig_across = 1.15            # rig: metres across the fabric and along
+//    rig_along = 0                # it the roi starts at (see camera_rig.hpp)
+//    backend = gstreamer          # capture backend; defaults to opencv
+//    codec = h264                 # gstreamer: h264 or h265
+//    latency_ms = 200             # gstreamer: rtspsrc jitter buffer
+//    drop = latest                # gstreamer: latest or none
+//    scale = 1280x720             # gstreamer: scale frames; empty is native
+//    transport = tcp              # tcp or udp; empty is the backend default
+//    probe_size = 32768           # opencv: bytes probed for the format
+//    analyze_duration_ms = 500    # opencv: time spent probing the streams
+//    max_delay_ms = 0             # opencv: demuxer (reorder) delay
+//    reorder_queue = 0            # opencv: RTP packets held for reordering
+//    low_delay = true             # don't buffer in demuxer and decoder
+//    ntp_timestamps = true        # gstreamer: stamp frames with the
+//                                 # camera's NTP time from its RTCP reports
+//
+//    [model stain]                # further models run on the same frames
+//    model = /path/stain.prototxt
+//    data = /path/stain.caffemodel
+//    mean_value = 104,117,123     # defaults to the global mean
+//    threshold = 0.3              # defaults to the camera threshold
+//
+// A loaded Config is immutable; components keep a pointer to the parts they
+// need instead of looking up strings on the hot path.
+//
+#ifndef TEXTILE_CONFIG_HPP_
+#define TEXTILE_CONFIG_HPP_
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace textile {
+
+struct Roi {
+  Roi() : x(0), y(0), width(0), height(0) {}
+
+  bool empty() const { return width <= 0 || height <= 0; }
+
+  int x;
+  int y;
+  int width;
+  int height;
+};
+
+struct CameraConfig {
+  CameraConfig()
+      : threshold(-1.f), sample_every(1), priority(0), fabric_speed(0.f),
+        pixels_per_metre(0.f), fabric_axis("y"), fov_length(0.f),
+        overlap(-1.f), rig_across(0.f), rig_along(0.f),
+        backend("opencv"), codec("h264"), latency_ms(200), drop("latest"),
+        scale_width(0), scale_height(0), probe_size(0),
+        analyze_duration_ms(-1), max_delay_ms(-1), reorder_queue(-1),
+        low_delay(false), ntp_timestamps(false) {}
+
+  std::string name;
+  /* Stream url; built from username/password/ip/path unless set. */
+  std::string url;
+  std::string username;
+  std::string password;
+  std::string ip;
+  std::string path;
+  Roi roi;
+  float threshold;
+  int sample_every;
+  int priority;
+  /* Metres of fabric per minute moving past the camera; 0 if unknown. */
+  float fabric_speed;
+  /* Scale of the fabric in the frame along fabric_axis ("x" or "y"); with
+   * it, the speed is measured from the frames instead. */
+  float pixels_per_metre;
+  std::string fabric_axis;
+  /* Metres of fabric the roi shows along fabric_axis; 0 if unknown. */
+  float fov_length;
+  /* Fraction of the view consecutive inspected frames share, when the
+   * fabric speed is known; negative inspects every sample_every-th frame
+   * regardless. */
+  float overlap;
+  /* Name of the rig the camera is part of, if any, and where its roi
+   * starts in the fabric frame of the rig. */
+  std::string rig;
+  float rig_across;
+  float rig_along;
+  /* How frames are captured: "opencv" (cv::VideoCapture) or "gstreamer"
+   * (see gst_stream.hpp), which uses the settings below. */
+  std::string backend;
+  std::string codec;
+  int latency_ms;
+  /* "latest" hands out only the newest frame, "none" queues frames. */
+  std::string drop;
+  /* Size frames are scaled to in the pipeline; 0 keeps the stream's. */
+  int scale_width;
+  int scale_height;
+  /* Capture tuning; empty, false or negative (probe_size: 0) keeps the
+   * backend's default. transport and low_delay apply to both backends (see
+   * rtsp_stream.hpp and gst_stream.hpp), the rest to opencv only. */
+  std::string transport;
+  int probe_size;
+  int analyze_duration_ms;
+  int max_delay_ms;
+  int reorder_queue;
+  bool low_delay;
+  /* gstreamer: take the capture time of frames from the RTCP sender
+   * reports of the camera, which must be NTP-synced (GStreamer 1.22 or
+   * later); otherwise it is estimated from the PTS. */
+  bool ntp_timestamps;
+};
+
+/* A model run on the same frames as the main one. */
+struct ModelConfig {
+  ModelConfig() : threshold(-1.f) {}
+
+  std::string name;
+  std::string model_file;
+  std::string weights_file;
+  std::string mean_file;
+  std::string mean_value;
+  /* Negative: use the threshold of the camera (or the global one). */
+  float threshold;
+};
+
+struct Config {
+  Config() : threshold(0.01f) {}
+
+  std::string model_file;
+  std::string weights_file;
+  std::string mean_file;
+  std::string mean_value;
+  /* image, video or rtsp. */
+  std::string type;
+  std::string list_file;
+  float threshold;
+  /* Sorted by descending priority. */
+  std::vector<CameraConfig> cameras;
+  /* In file order. */
+  std::vector<ModelConfig> models;
+};
+
+/* Parse and validate. On failure returns false and fills error with one
+ * line per problem found. */
+bool ParseConfig(std::istream& in, Config* config, std::string* error);
+
+/* Load path, or log every problem and abort. */
+std::shared_ptr<const Config> LoadConfigOrDie(const std::string& path);
+
+}  // namespace textile
+
+#endif  // TEXTILE_CONFIG_HPP_
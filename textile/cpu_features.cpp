@@ -0,0 +1,85 @@
+#include "textile/cpu_features.hpp"
+
+#include <stdlib.h>
+
+#include <atomic>
+#include <string>
+
+#include <glog/logging.h>
+
+namespace textile {
+
+static const char* const kCpuLevelNames[kNumCpuLevels] = {
+  "scalar", "sse4.2", "avx2", "avx512"
+};
+
+/* -1 until first use, then the active CpuLevel. */
+static std::atomic<int> active_level(-1);
+
+const char* CpuLevelName(CpuLevel level) {
+  return kCpuLevelNames[level];
+}
+
+bool ParseCpuLevel(const std::string& name, CpuLevel* level) {
+  for (int i = 0; i < kNumCpuLevels; ++i) {
+    if (name == kCpuLevelNames[i]) {
+      *level = static_cast<CpuLevel>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+CpuLevel DetectCpuLevel() {
+#if defined(__x86_64__) || defined(__i386__)
+  // __builtin_cpu_supports also checks that the OS saves the wider
+  // registers (XCR0), so AVX levels are only reported when usable.
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+    return kCpuAVX512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return kCpuAVX2;
+  }
+  if (__builtin_cpu_supports("sse4.2")) {
+    return kCpuSSE42;
+  }
+#endif
+  return kCpuScalar;
+}
+
+CpuLevel ActiveCpuLevel() {
+  int level = active_level.load(std::memory_order_acquire);
+  if (level < 0) {
+    level = DetectCpuLevel();
+    const char* forced = getenv("TEXTILE_CPU_DISPATCH");
+    CpuLevel parsed;
+    if (forced != NULL && ParseCpuLevel(forced, &parsed)) {
+      if (parsed <= level) {
+        level = parsed;
+      } else {
+        LOG(WARNING) << "TEXTILE_CPU_DISPATCH=" << forced
+                     << " is not supported by this CPU, using "
+                     << kCpuLevelNames[level];
+      }
+    }
+    active_level.store(level, std::memory_order_release);
+  }
+  return static_cast<CpuLevel>(level);
+}
+
+bool ForceCpuLevel(const std::string& name) {
+  if (name == "auto") {
+    // Detect again on next use, honouring TEXTILE_CPU_DISPATCH.
+    active_level.store(-1, std::memory_order_release);
+    return true;
+  }
+  CpuLevel level;
+  if (!ParseCpuLevel(name, &level) || level > DetectCpuLevel()) {
+    return false;
+  }
+  active_level.store(level, std::memory_order_release);
+  return true;
+}
+
+}  // namespace textile
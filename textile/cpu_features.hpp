@@ -0,0 +1,41 @@
+// Runtime CPU feature detection for the dispatched kernels.
+//
+// The level is detected once; it can be forced down (never up) for testing
+// with ForceCpuLevel() or the TEXTILE_CPU_DISPATCH environment variable,
+// which takes the same names as CpuLevelName().
+//
+#ifndef TEXTILE_CPU_FEATURES_HPP_
+#define TEXTILE_CPU_FEATURES_HPP_
+
+#include <string>
+
+namespace textile {
+
+enum CpuLevel {
+  kCpuScalar = 0,
+  kCpuSSE42,
+  kCpuAVX2,
+  kCpuAVX512,
+  kNumCpuLevels
+};
+
+const char* CpuLevelName(CpuLevel level);
+
+/* Parse a level name ("scalar", "sse4.2", "avx2", "avx512"). Returns false
+ * if name is not one of them. */
+bool ParseCpuLevel(const std::string& name, CpuLevel* level);
+
+/* Highest level both the CPU and the OS support. */
+CpuLevel DetectCpuLevel();
+
+/* Level the kernels are bound to: the detected one unless forced. */
+CpuLevel ActiveCpuLevel();
+
+/* Bind the kernels to level instead of the detected one. "auto" restores
+ * detection, TEXTILE_CPU_DISPATCH included. Fails for unknown names and
+ * levels the CPU lacks. */
+bool ForceCpuLevel(const std::string& name);
+
+}  // namespace textile
+
+#endif  // TEXTILE_CPU_FEATURES_HPP_
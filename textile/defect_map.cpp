@@ -0,0 +1,113 @@
+#include "textile/defect_map.hpp"
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+namespace textile {
+
+const double DefectMap::kLongDefect = 1.;
+
+DefectMap::DefectMap(double merge_distance)
+    : merge_distance_(merge_distance), next_id_(0) {
+  CHECK_GE(merge_distance, 0.);
+}
+
+/* Whether a sighting of model and label at box is to merge into defect. */
+static bool Overlaps(const FabricDefect& defect, int model, int label,
+                     const FabricBox& box, double merge_distance) {
+  return defect.model == model && defect.label == label &&
+      defect.box.along_max + merge_distance >= box.along_min &&
+      defect.box.along_min - merge_distance <= box.along_max &&
+      defect.box.across_max + merge_distance >= box.across_min &&
+      defect.box.across_min - merge_distance <= box.across_max;
+}
+
+int DefectMap::Add(int model, int label, float score, const FabricBox& box,
+                   int64_t time_ms) {
+  // A short defect overlapping the box starts at most kLongDefect before
+  // it; the first along the roll takes the sighting.
+  int found = -1;
+  std::multimap<double, int>::iterator it = index_.lower_bound(
+      box.along_min - merge_distance_ - kLongDefect);
+  const std::multimap<double, int>::iterator end =
+      index_.upper_bound(box.along_max + merge_distance_);
+  for (; it != end; ++it) {
+    if (Overlaps(defects_[it->second], model, label, box, merge_distance_)) {
+      found = it->second;
+      break;
+    }
+  }
+  for (size_t i = 0; i < long_.size(); ++i) {
+    const FabricDefect& defect = defects_[long_[i]];
+    if (Overlaps(defect, model, label, box, merge_distance_) &&
+        (found < 0 ||
+         defect.box.along_min < defects_[found].box.along_min)) {
+      found = long_[i];
+    }
+  }
+
+  if (found >= 0) {
+    FabricDefect& defect = defects_[found];
+    const bool was_long =
+        defect.box.along_max - defect.box.along_min > kLongDefect;
+    if (box.along_min < defect.box.along_min) {
+      std::pair<std::multimap<double, int>::iterator,
+                std::multimap<double, int>::iterator> range =
+          index_.equal_range(defect.box.along_min);
+      for (it = range.first; it != range.second; ++it) {
+        if (it->second == found) {
+          index_.erase(it);
+          break;
+        }
+      }
+      index_.insert(std::make_pair(box.along_min, found));
+      defect.box.along_min = box.along_min;
+    }
+    defect.box.along_max = std::max(defect.box.along_max, box.along_max);
+    defect.box.across_min = std::min(defect.box.across_min, box.across_min);
+    defect.box.across_max = std::max(defect.box.across_max, box.across_max);
+    defect.score = std::max(defect.score, score);
+    ++defect.hits;
+    defect.last_ms = time_ms;
+    if (!was_long &&
+        defect.box.along_max - defect.box.along_min > kLongDefect) {
+      long_.push_back(found);
+    }
+    return found;
+  }
+
+  FabricDefect defect;
+  defect.id = next_id_++;
+  defect.model = model;
+  defect.label = label;
+  defect.score = score;
+  defect.box = box;
+  defect.hits = 1;
+  defect.first_ms = time_ms;
+  defect.last_ms = time_ms;
+  defects_.push_back(defect);
+  const int index = static_cast<int>(defects_.size()) - 1;
+  index_.insert(std::make_pair(box.along_min, index));
+  if (box.along_max - box.along_min > kLongDefect) {
+    long_.push_back(index);
+  }
+  return index;
+}
+
+void DefectMap::Sorted(std::vector<int>* order) const {
+  order->clear();
+  order->reserve(index_.size());
+  for (std::multimap<double, int>::const_iterator it = index_.begin();
+       it != index_.end(); ++it) {
+    order->push_back(it->second);
+  }
+}
+
+void DefectMap::Clear() {
+  defects_.clear();
+  index_.clear();
+  long_.clear();
+}
+
+}  // namespace textile
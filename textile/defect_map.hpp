@@ -0,0 +1,87 @@
+// Defects of a roll of fabric, in fabric coordinates.
+//
+// A defect is seen on every inspected frame it passes through, at a
+// different place in each. Mapped to the fabric -- metres along the roll,
+// from the motion of the fabric, and metres across it -- those sightings
+// land on the same spot, and DefectMap merges each into the defect it
+// overlaps (within merge_distance, same model and label), so a roll yields
+// one record per defect instead of one per frame.
+//
+// Defects are indexed by where they start along the roll in a sorted
+// multimap. A defect up to kLongDefect metres long that overlaps a new
+// sighting starts at most that much before it: one O(log n) lookup and a
+// short scan, however long the roll gets. The few longer ones (a streak
+// running down the roll) are kept in a list of their own and checked one
+// by one, so that one of them does not widen the scan for all others.
+//
+#ifndef TEXTILE_DEFECT_MAP_HPP_
+#define TEXTILE_DEFECT_MAP_HPP_
+
+#include <stdint.h>
+
+#include <map>
+#include <vector>
+
+namespace textile {
+
+/* A box on the fabric, in metres: along the roll and across it. */
+struct FabricBox {
+  FabricBox() : along_min(0.), along_max(0.), across_min(0.), across_max(0.) {}
+
+  double along_min;
+  double along_max;
+  double across_min;
+  double across_max;
+};
+
+struct FabricDefect {
+  int64_t id;
+  int model;
+  int label;
+  /* The best score of its sightings. */
+  float score;
+  /* Union of the boxes of its sightings. */
+  FabricBox box;
+  /* Sightings merged into it, and the wall times (ms since the epoch) of
+   * the first and last. */
+  int hits;
+  int64_t first_ms;
+  int64_t last_ms;
+};
+
+class DefectMap {
+ public:
+  /* Metres along the roll past which a defect is checked apart. */
+  static const double kLongDefect;
+
+  /* Sightings closer than merge_distance metres to a defect, both along
+   * and across, are merged into it. */
+  explicit DefectMap(double merge_distance);
+
+  /* Merge a sighting into the first defect it overlaps, or start a new
+   * one. Returns the index of the defect in defects(). */
+  int Add(int model, int label, float score, const FabricBox& box,
+          int64_t time_ms);
+
+  /* In the order they were first seen. */
+  const std::vector<FabricDefect>& defects() const { return defects_; }
+
+  /* Indices into defects() in order along the roll. */
+  void Sorted(std::vector<int>* order) const;
+
+  /* Start over for a new roll; ids keep counting. */
+  void Clear();
+
+ private:
+  double merge_distance_;
+  int64_t next_id_;
+  std::vector<FabricDefect> defects_;
+  /* along_min of each defect to its index. */
+  std::multimap<double, int> index_;
+  /* Indices of the defects longer than kLongDefect. */
+  std::vector<int> long_;
+};
+
+}  // namespace textile
+
+#endif  // TEXTILE_DEFECT_MAP_HPP_
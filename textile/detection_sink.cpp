@@ -0,0 +1,13 @@
+#include "textile/detection_sink.hpp"
+
+#include <sys/time.h>
+
+namespace textile {
+
+int64_t WallTimeMs() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return static_cast<int64_t>(tv.tv_sec) * 1000 + tv.tv_usec / 1000;
+}
+
+}  // namespace textile
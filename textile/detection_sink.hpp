@@ -0,0 +1,69 @@
+// Destinations for detection results besides the text output.
+//
+// detect_textile hands every frame's detections to each configured sink as
+// one batch. Sinks are called from the inference loop and must not hold it
+// up for long.
+//
+#ifndef TEXTILE_DETECTION_SINK_HPP_
+#define TEXTILE_DETECTION_SINK_HPP_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "textile/metrics.hpp"
+
+namespace textile {
+
+struct DetectionRecord {
+  DetectionRecord()
+      : time_ms(0), frame(0), label(0), score(0.f),
+        xmin(0.f), ymin(0.f), xmax(0.f), ymax(0.f) {}
+
+  int64_t time_ms;     // wall clock, milliseconds since the epoch
+  int64_t frame;       // frame number within the source
+  std::string camera;  // camera name, or the file for image/video input
+  std::string model;   // model name (see MultiModelRunner)
+  int label;
+  float score;
+  // Box in pixels of the full frame.
+  float xmin;
+  float ymin;
+  float xmax;
+  float ymax;
+};
+
+/* Something that happened to a source, e.g. a reconnect. */
+struct EventRecord {
+  EventRecord() : time_ms(0) {}
+
+  int64_t time_ms;
+  std::string camera;
+  std::string kind;
+  std::string detail;
+};
+
+class DetectionSink {
+ public:
+  virtual ~DetectionSink() {}
+
+  /* Take the detections of one frame. */
+  virtual void Write(const std::vector<DetectionRecord>& records) = 0;
+
+  /* Sinks that do not keep events ignore them. */
+  virtual void WriteEvent(const EventRecord& event) {}
+
+  /* Make everything written so far durable. */
+  virtual void Flush() {}
+
+  /* Publish the sink's counters, if it has any. */
+  virtual void ExportMetrics(Metrics* metrics) const {}
+};
+
+/* Milliseconds since the epoch. */
+int64_t WallTimeMs();
+
+}  // namespace textile
+
+#endif  // TEXTILE_DETECTION_SINK_HPP_
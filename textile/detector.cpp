@@ -0,0 +1,302 @@
+#include "textile/detector.hpp"
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "textile/kernels.hpp"
+
+namespace textile {
+
+using caffe::Blob;
+using caffe::BlobProto;
+using caffe::Caffe;
+using caffe::Net;
+using caffe::ReadProtoFromBinaryFileOrDie;
+using caffe::TEST;
+using std::string;
+using std::stringstream;
+using std::vector;
+
+void BindCaffeMode() {
+#ifdef CPU_ONLY
+  Caffe::set_mode(Caffe::CPU);
+#else
+  Caffe::set_mode(Caffe::GPU);
+#endif
+}
+
+Detector::Detector(const string& model_file,
+                   const string& weights_file,
+                   const string& mean_file,
+                   const string& mean_value) {
+  BindCaffeMode();
+
+  /* Load the network. */
+  net_.reset(new Net<float>(model_file, TEST));
+  net_->CopyTrainedLayersFrom(weights_file);
+
+  CHECK_EQ(net_->num_inputs(), 1) << "Network should have exactly one input.";
+  CHECK_EQ(net_->num_outputs(), 1) << "Network should have exactly one output.";
+
+  Blob<float>* input_layer = net_->input_blobs()[0];
+  num_channels_ = input_layer->channels();
+  CHECK(num_channels_ == 3 || num_channels_ == 1)
+    << "Input layer should have 1 or 3 channels.";
+  input_geometry_ = cv::Size(input_layer->width(), input_layer->height());
+
+  /* Load the binaryproto mean file. */
+  SetMean(mean_file, mean_value);
+}
+
+const Blob<float>* Detector::PrepareInput(const cv::Mat* imgs, int num) {
+  Blob<float>* input_layer = net_->input_blobs()[0];
+  input_layer->Reshape(num, num_channels_,
+                       input_geometry_.height, input_geometry_.width);
+  /* Forward dimension change to all layers. */
+  net_->Reshape();
+
+  for (int n = 0; n < num; ++n) {
+    input_channels_.clear();
+    WrapInputLayer(n, &input_channels_);
+    Preprocess(imgs[n], &input_channels_);
+  }
+  return input_layer;
+}
+
+Blob<float>* Detector::Forward(const cv::Mat* imgs, int num) {
+  PrepareInput(imgs, num);
+  net_->Forward();
+  return net_->output_blobs()[0];
+}
+
+void Detector::ForwardPrepared(const Blob<float>& input) {
+  Blob<float>* input_layer = net_->input_blobs()[0];
+  if (&input != input_layer) {
+    CHECK(input.channels() == num_channels_ &&
+          input.height() == input_geometry_.height &&
+          input.width() == input_geometry_.width)
+      << "Input was prepared for a different geometry.";
+    input_layer->ReshapeLike(input);
+    net_->Reshape();
+    input_layer->ShareData(input);
+  }
+  net_->Forward();
+}
+
+std::vector<vector<float> > Detector::Detect(const cv::Mat& img) {
+  /* Copy the output layer to a std::vector */
+  Blob<float>* result_blob = Forward(&img, 1);
+  const float* result = result_blob->cpu_data();
+  const int num_det = result_blob->height();
+  vector<vector<float> > detections;
+  for (int k = 0; k < num_det; ++k) {
+    if (result[0] == -1) {
+      // Skip invalid detection.
+      result += 7;
+      continue;
+    }
+    vector<float> detection(result, result + 7);
+    detections.push_back(detection);
+    result += 7;
+  }
+  return detections;
+}
+
+int Detector::Detect(const cv::Mat& img, float threshold,
+                     Detection* detections, int capacity) {
+  int count = 0;
+  DetectBatch(&img, 1, threshold, detections, capacity, &count);
+  return count;
+}
+
+void Detector::DetectBatch(const cv::Mat* imgs, int num, float threshold,
+                           Detection* detections, int capacity,
+                           int* counts) {
+  if (num > 0) {
+    Forward(imgs, num);
+  }
+  Collect(imgs, num, threshold, detections, capacity, counts);
+}
+
+void Detector::Collect(const cv::Mat* imgs, int num, float threshold,
+                       Detection* detections, int capacity,
+                       int* counts) const {
+  for (int i = 0; i < num; ++i) {
+    counts[i] = 0;
+  }
+  if (num <= 0) {
+    return;
+  }
+  const Blob<float>* result_blob = net_->output_blobs()[0];
+  const float* result = result_blob->cpu_data();
+  const int num_det = result_blob->height();
+  for (int k = 0; k < num_det; ++k, result += 7) {
+    // Skip invalid detection and those under the threshold.
+    const int image_id = static_cast<int>(result[0]);
+    if (image_id < 0 || image_id >= num || result[2] < threshold) {
+      continue;
+    }
+    const cv::Mat& img = imgs[image_id];
+    int& count = counts[image_id];
+    if (count < capacity) {
+      Detection& d = detections[image_id * capacity + count];
+      d.label = static_cast<int>(result[1]);
+      d.score = result[2];
+      d.xmin = result[3] * img.cols;
+      d.ymin = result[4] * img.rows;
+      d.xmax = result[5] * img.cols;
+      d.ymax = result[6] * img.rows;
+    }
+    ++count;
+  }
+}
+
+void Detector::AccountMemory(MemoryReport* report) const {
+  AccountNet(*net_, report);
+  report->bytes[kMemWeights] += mean_.total() * mean_.elemSize();
+}
+
+/* Load the mean file in binaryproto format. */
+void Detector::SetMean(const string& mean_file, const string& mean_value) {
+  cv::Scalar channel_mean;
+  if (!mean_file.empty()) {
+    CHECK(mean_value.empty()) <<
+      "Cannot specify mean_file and mean_value at the same time";
+    BlobProto blob_proto;
+    ReadProtoFromBinaryFileOrDie(mean_file.c_str(), &blob_proto);
+
+    /* Convert from BlobProto to Blob<float> */
+    Blob<float> mean_blob;
+    mean_blob.FromProto(blob_proto);
+    CHECK_EQ(mean_blob.channels(), num_channels_)
+      << "Number of channels of mean file doesn't match input layer.";
+
+    /* The format of the mean file is planar 32-bit float BGR or grayscale. */
+    std::vector<cv::Mat> channels;
+    float* data = mean_blob.mutable_cpu_data();
+    for (int i = 0; i < num_channels_; ++i) {
+      /* Extract an individual channel. */
+      cv::Mat channel(mean_blob.height(), mean_blob.width(), CV_32FC1, data);
+      channels.push_back(channel);
+      data += mean_blob.height() * mean_blob.width();
+    }
+
+    /* Merge the separate channels into a single image. */
+    cv::Mat mean;
+    cv::merge(channels, mean);
+
+    /* Compute the global mean pixel value and create a mean image
+     * filled with this value. */
+    channel_mean = cv::mean(mean);
+    mean_ = cv::Mat(input_geometry_, mean.type(), channel_mean);
+    mean_values_.assign(channel_mean.val, channel_mean.val + num_channels_);
+  }
+  if (!mean_value.empty()) {
+    CHECK(mean_file.empty()) <<
+      "Cannot specify mean_file and mean_value at the same time";
+    stringstream ss(mean_value);
+    vector<float> values;
+    string item;
+    while (getline(ss, item, ',')) {
+      float value = std::atof(item.c_str());
+      values.push_back(value);
+    }
+    CHECK(values.size() == 1 || values.size() == num_channels_) <<
+      "Specify either 1 mean_value or as many as channels: " << num_channels_;
+
+    std::vector<cv::Mat> channels;
+    mean_values_.clear();
+    for (int i = 0; i < num_channels_; ++i) {
+      const float value = values.size() == 1 ? values[0] : values[i];
+      mean_values_.push_back(value);
+      /* Extract an individual channel. */
+      cv::Mat channel(input_geometry_.height, input_geometry_.width, CV_32FC1,
+          cv::Scalar(value));
+      channels.push_back(channel);
+    }
+    cv::merge(channels, mean_);
+  }
+}
+
+/* Wrap the input layer of the network in separate cv::Mat objects
+ * (one per channel). This way we save one memcpy operation and we
+ * don't need to rely on cudaMemcpy2D. The last preprocessing
+ * operation will write the separate channels directly to the input
+ * layer. */
+void Detector::WrapInputLayer(int n, std::vector<cv::Mat>* input_channels) {
+  Blob<float>* input_layer = net_->input_blobs()[0];
+
+  int width = input_layer->width();
+  int height = input_layer->height();
+  float* input_data = input_layer->mutable_cpu_data() + input_layer->offset(n);
+  for (int i = 0; i < input_layer->channels(); ++i) {
+    cv::Mat channel(height, width, CV_32FC1, input_data);
+    input_channels->push_back(channel);
+    input_data += width * height;
+  }
+}
+
+void Detector::Preprocess(const cv::Mat& img,
+                            std::vector<cv::Mat>* input_channels) {
+  /* Convert the input image to the input image format of the network.
+   * Conversions go to member buffers that are only ever written by us, so
+   * they are reused across calls; img itself is never written to. */
+  cv::Mat sample = converted_;
+  if (img.channels() == 3 && num_channels_ == 1)
+    cv::cvtColor(img, sample, cv::COLOR_BGR2GRAY);
+  else if (img.channels() == 4 && num_channels_ == 1)
+    cv::cvtColor(img, sample, cv::COLOR_BGRA2GRAY);
+  else if (img.channels() == 4 && num_channels_ == 3)
+    cv::cvtColor(img, sample, cv::COLOR_BGRA2BGR);
+  else if (img.channels() == 1 && num_channels_ == 3)
+    cv::cvtColor(img, sample, cv::COLOR_GRAY2BGR);
+  else
+    sample = img;
+  if (sample.data != img.data)
+    converted_ = sample;
+
+  cv::Mat sample_resized;
+  if (sample.size() != input_geometry_) {
+    cv::resize(sample, resized_, input_geometry_);
+    sample_resized = resized_;
+  } else {
+    sample_resized = sample;
+  }
+
+  /* 8-bit samples are converted, mean subtracted and split into the input
+   * layer in a single pass by the dispatched kernel. */
+  if (sample_resized.depth() == CV_8U &&
+      sample_resized.channels() == num_channels_ &&
+      mean_values_.size() == static_cast<size_t>(num_channels_)) {
+    GetKernels().hwc_to_planar(sample_resized.data,
+                               sample_resized.cols, sample_resized.rows,
+                               static_cast<int>(sample_resized.step[0]),
+                               num_channels_, &mean_values_[0],
+                               input_channels->at(0).ptr<float>());
+    return;
+  }
+
+  cv::Mat sample_float;
+  if (num_channels_ == 3)
+    sample_resized.convertTo(sample_float, CV_32FC3);
+  else
+    sample_resized.convertTo(sample_float, CV_32FC1);
+
+  cv::Mat sample_normalized;
+  cv::subtract(sample_float, mean_, sample_normalized);
+
+  const float* input_data = input_channels->at(0).ptr<float>();
+
+  /* This operation will write the separate BGR planes directly to the
+   * input layer of the network because it is wrapped by the cv::Mat
+   * objects in input_channels. */
+  cv::split(sample_normalized, *input_channels);
+
+  CHECK(input_channels->at(0).ptr<float>() == input_data)
+    << "Input channels are not wrapping the input layer of the network.";
+}
+
+}  // namespace textile
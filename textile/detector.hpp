@@ -0,0 +1,103 @@
+// SSD detector wrapping a Caffe net.
+//
+// The code is modified from examples/cpp_classification/classification.cpp
+// and is shared by every tool in this repository.
+//
+#ifndef TEXTILE_DETECTOR_HPP_
+#define TEXTILE_DETECTOR_HPP_
+
+#include <caffe/caffe.hpp>
+#include <opencv2/core/core.hpp>
+
+#include <string>
+#include <vector>
+
+#include "textile/memory_profile.hpp"
+
+namespace textile {
+
+/* One detection in pixel coordinates of the image passed to Detect. */
+struct Detection {
+  int label;
+  float score;
+  float xmin;
+  float ymin;
+  float xmax;
+  float ymax;
+};
+
+/* Put the calling thread's Caffe in the mode the library was built for.
+ * Caffe keeps its mode per thread, so every thread that runs a net calls
+ * this once. */
+void BindCaffeMode();
+
+class Detector {
+ public:
+  Detector(const std::string& model_file,
+           const std::string& weights_file,
+           const std::string& mean_file,
+           const std::string& mean_value);
+
+  /* Detection format: [image_id, label, score, xmin, ymin, xmax, ymax],
+   * with coordinates relative to the image size. */
+  std::vector<std::vector<float> > Detect(const cv::Mat& img);
+
+  /* Detect into a caller-provided array, keeping only detections with a
+   * score of at least threshold. Returns how many there are, which may be
+   * more than capacity; only the first capacity ones are written. Once the
+   * image size is stable this does not allocate. */
+  int Detect(const cv::Mat& img, float threshold,
+             Detection* detections, int capacity);
+
+  /* Run num images through the net as one batch. Image i gets the slots
+   * detections[i * capacity, (i + 1) * capacity) and counts[i] receives
+   * its total number of detections, as for Detect above. */
+  void DetectBatch(const cv::Mat* imgs, int num, float threshold,
+                   Detection* detections, int capacity, int* counts);
+
+  /* The steps of DetectBatch, for callers that share one preprocessed
+   * input between several nets (see MultiModelRunner). PrepareInput
+   * preprocesses num images into this net's input blob and returns it;
+   * ForwardPrepared runs the net on an input prepared by a detector with
+   * the same input geometry and mean, without copying it; Collect reads
+   * the detections of the last forward pass like DetectBatch. */
+  const caffe::Blob<float>* PrepareInput(const cv::Mat* imgs, int num);
+  void ForwardPrepared(const caffe::Blob<float>& input);
+  void Collect(const cv::Mat* imgs, int num, float threshold,
+               Detection* detections, int capacity, int* counts) const;
+
+  cv::Size input_geometry() const { return input_geometry_; }
+  int num_channels() const { return num_channels_; }
+  const std::vector<float>& mean_values() const { return mean_values_; }
+
+  /* Add the memory held by the network and the mean image to report. */
+  void AccountMemory(MemoryReport* report) const;
+
+ private:
+  /* Run the net on a batch of num images; returns the output blob. */
+  caffe::Blob<float>* Forward(const cv::Mat* imgs, int num);
+
+  void SetMean(const std::string& mean_file, const std::string& mean_value);
+
+  /* Wrap the channels of image n of the input batch. */
+  void WrapInputLayer(int n, std::vector<cv::Mat>* input_channels);
+
+  void Preprocess(const cv::Mat& img,
+                  std::vector<cv::Mat>* input_channels);
+
+ private:
+  boost::shared_ptr<caffe::Net<float> > net_;
+  cv::Size input_geometry_;
+  int num_channels_;
+  cv::Mat mean_;
+  /* Per-channel value mean_ is filled with, for the fused kernel. */
+  std::vector<float> mean_values_;
+  /* Buffers reused from call to call. */
+  std::vector<cv::Mat> input_channels_;
+  cv::Mat converted_;
+  cv::Mat resized_;
+};
+
+}  // namespace textile
+
+#endif  // TEXTILE_DETECTOR_HPP_
@@ -0,0 +1,113 @@
+#include "textile/frame_grid.hpp"
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+namespace textile {
+
+/* Rows of 8-bit values a uint16_t column sum holds without wrapping. */
+static const int kMaxBandRows = 65535 / 255;
+/* Rows per accumulate_rows call: more rows walk the frame in more
+ * interleaved streams than the prefetchers follow. */
+static const int kRowsPerCall = 16;
+
+GridSampler::GridSampler(int cols, int rows, const Kernels& kernels)
+    : cols_(cols), rows_(rows), kernels_(kernels) {
+  CHECK_GT(cols, 0);
+  CHECK_GT(rows, 0);
+}
+
+void GridSampler::FoldBand(int width, int channels) {
+  for (int c = 0; c < cols_; ++c) {
+    uint32_t* sums = &cell_sums_[c * channels];
+    const uint16_t* column = &column_sums_[cell_x_[c] * channels];
+    const uint16_t* end = &column_sums_[0] + cell_x_[c + 1] * channels;
+    if (channels == 1) {
+      uint32_t sum = 0;
+      for (; column < end; ++column) {
+        sum += *column;
+      }
+      sums[0] += sum;
+    } else {
+      uint32_t b = 0, g = 0, r = 0;
+      for (; column < end; column += 3) {
+        b += column[0];
+        g += column[1];
+        r += column[2];
+      }
+      sums[0] += b;
+      sums[1] += g;
+      sums[2] += r;
+    }
+  }
+  std::fill(column_sums_.begin(), column_sums_.begin() + width * channels, 0);
+}
+
+void GridSampler::Downsample(const uint8_t* src, int width, int height,
+                             int src_stride, int channels, FrameGrid* grid) {
+  CHECK(channels == 1 || channels == 3) << "Unsupported channels: "
+                                        << channels;
+  CHECK_GE(width, cols_);
+  CHECK_GE(height, rows_);
+  grid->cols = cols_;
+  grid->rows = rows_;
+  grid->channels = channels;
+  grid->cells.resize(cols_ * rows_ * channels);
+  cell_x_.resize(cols_ + 1);
+  for (int c = 0; c <= cols_; ++c) {
+    cell_x_[c] = static_cast<int>(static_cast<int64_t>(width) * c / cols_);
+  }
+  column_sums_.assign(width * channels, 0);
+  cell_sums_.resize(cols_ * channels);
+
+  for (int r = 0; r < rows_; ++r) {
+    const int y0 = static_cast<int>(static_cast<int64_t>(height) * r / rows_);
+    const int y1 =
+        static_cast<int>(static_cast<int64_t>(height) * (r + 1) / rows_);
+    std::fill(cell_sums_.begin(), cell_sums_.end(), 0);
+    int band_rows = 0;
+    for (int y = y0; y < y1; y += kRowsPerCall) {
+      const int call_rows = std::min(y1 - y, kRowsPerCall);
+      if (band_rows + call_rows > kMaxBandRows) {
+        FoldBand(width, channels);
+        band_rows = 0;
+      }
+      kernels_.accumulate_rows(src + static_cast<int64_t>(y) * src_stride,
+                               src_stride, call_rows, width * channels,
+                               &column_sums_[0]);
+      band_rows += call_rows;
+    }
+    FoldBand(width, channels);
+    uint8_t* out = &grid->cells[r * cols_ * channels];
+    for (int c = 0; c < cols_; ++c) {
+      const uint32_t area = (cell_x_[c + 1] - cell_x_[c]) * (y1 - y0);
+      for (int k = 0; k < channels; ++k) {
+        out[c * channels + k] = static_cast<uint8_t>(
+            (cell_sums_[c * channels + k] + area / 2) / area);
+      }
+    }
+  }
+}
+
+void CompareGrids(const FrameGrid& a, const FrameGrid& b, GridDiff* diff,
+                  const Kernels& kernels) {
+  CHECK(a.cols == b.cols && a.rows == b.rows && a.channels == b.channels)
+      << "Grids of different shapes";
+  const int cells = a.cols * a.rows;
+  diff->sad = 0;
+  diff->ssd = 0;
+  diff->change.resize(cells);
+  std::vector<uint8_t> values(a.cells.size());
+  kernels.abs_diff(&a.cells[0], &b.cells[0], static_cast<int>(values.size()),
+                   &values[0], &diff->sad, &diff->ssd);
+  for (int i = 0; i < cells; ++i) {
+    uint16_t sum = 0;
+    for (int k = 0; k < a.channels; ++k) {
+      sum = static_cast<uint16_t>(sum + values[i * a.channels + k]);
+    }
+    diff->change[i] = sum;
+  }
+}
+
+}  // namespace textile
@@ -0,0 +1,73 @@
+// Frames shrunk to coarse grids of cell means, and differences of grids.
+//
+// Change detection only needs to know which parts of a frame moved, not
+// where exactly: a 1080p frame is box-filtered down to, say, 64 x 36
+// cells in one pass over its pixels, and two grids are then compared cell
+// by cell. The rows of each band of cells are added to per-column sums
+// with the accumulate_rows kernel (see kernels.hpp), which are folded into
+// the cells once per band, so the per-pixel work is a single vector add.
+//
+#ifndef TEXTILE_FRAME_GRID_HPP_
+#define TEXTILE_FRAME_GRID_HPP_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "textile/kernels.hpp"
+
+namespace textile {
+
+/* cols x rows cells, each the rounded mean of its pixels, channels values
+ * per cell interleaved like the pixels were. */
+struct FrameGrid {
+  FrameGrid() : cols(0), rows(0), channels(0) {}
+
+  int cols;
+  int rows;
+  int channels;
+  std::vector<uint8_t> cells;
+};
+
+/* Per-cell difference of two grids. */
+struct GridDiff {
+  GridDiff() : sad(0), ssd(0) {}
+
+  /* Sums over all cells and channels of |a - b| and (a - b)^2. */
+  uint64_t sad;
+  uint64_t ssd;
+  /* The change map: |a - b| of each cell, summed over its channels. */
+  std::vector<uint16_t> change;
+};
+
+class GridSampler {
+ public:
+  /* Grids of cols x rows cells, computed with the given kernels. */
+  GridSampler(int cols, int rows, const Kernels& kernels = GetKernels());
+
+  /* Shrink an 8-bit image of 1 (gray, or the Y plane of NV12) or 3 (BGR)
+   * interleaved channels, rows src_stride bytes apart. Frames smaller than
+   * the grid are not supported. The sums are reused from call to call. */
+  void Downsample(const uint8_t* src, int width, int height, int src_stride,
+                  int channels, FrameGrid* grid);
+
+ private:
+  /* Add the column sums of the band into the cell sums and clear them. */
+  void FoldBand(int width, int channels);
+
+  int cols_;
+  int rows_;
+  const Kernels& kernels_;
+  /* First column of each cell, and the width for the last. */
+  std::vector<int> cell_x_;
+  std::vector<uint16_t> column_sums_;
+  std::vector<uint32_t> cell_sums_;
+};
+
+/* Compare two grids of the same shape in one pass. */
+void CompareGrids(const FrameGrid& a, const FrameGrid& b, GridDiff* diff,
+                  const Kernels& kernels = GetKernels());
+
+}  // namespace textile
+
+#endif  // TEXTILE_FRAME_GRID_HPP_
@@ -0,0 +1,44 @@
+#include "textile/frame_hash.hpp"
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <glog/logging.h>
+
+namespace textile {
+
+int HashDistance(const FrameHash& a, const FrameHash& b) {
+  int distance = 0;
+  for (size_t i = 0; i < sizeof(a.bits) / sizeof(a.bits[0]); ++i) {
+    distance += __builtin_popcountll(a.bits[i] ^ b.bits[i]);
+  }
+  return distance;
+}
+
+FrameHash FrameHasher::Compute(const cv::Mat& img) {
+  CHECK_EQ(img.depth(), CV_8U) << "Only 8-bit frames are hashed";
+  // Shrink first, so that the color conversion only sees the thumbnail.
+  cv::resize(img, small_, cv::Size(kFrameHashSide + 1, kFrameHashSide), 0,
+             0, cv::INTER_AREA);
+  const cv::Mat* gray = &small_;
+  if (small_.channels() == 3) {
+    cv::cvtColor(small_, gray_, cv::COLOR_BGR2GRAY);
+    gray = &gray_;
+  } else if (small_.channels() == 4) {
+    cv::cvtColor(small_, gray_, cv::COLOR_BGRA2GRAY);
+    gray = &gray_;
+  }
+
+  FrameHash hash = {};
+  int bit = 0;
+  for (int y = 0; y < kFrameHashSide; ++y) {
+    const uint8_t* row = gray->ptr<uint8_t>(y);
+    for (int x = 0; x < kFrameHashSide; ++x, ++bit) {
+      if (row[x] > row[x + 1]) {
+        hash.bits[bit / 64] |= uint64_t(1) << (bit % 64);
+      }
+    }
+  }
+  return hash;
+}
+
+}  // namespace textile
@@ -0,0 +1,39 @@
+// Perceptual hashes of frames.
+//
+// A difference hash: the frame is shrunk to a (kFrameHashSide + 1) x
+// kFrameHashSide gray thumbnail and every bit says whether a pixel is
+// brighter than its right neighbour. Frames that look alike have hashes a
+// few bits apart, whatever the noise, compression or exposure drift.
+//
+#ifndef TEXTILE_FRAME_HASH_HPP_
+#define TEXTILE_FRAME_HASH_HPP_
+
+#include <stdint.h>
+
+#include <opencv2/core/core.hpp>
+
+namespace textile {
+
+static const int kFrameHashSide = 16;
+
+struct FrameHash {
+  uint64_t bits[kFrameHashSide * kFrameHashSide / 64];
+};
+
+/* Number of differing bits. */
+int HashDistance(const FrameHash& a, const FrameHash& b);
+
+class FrameHasher {
+ public:
+  /* Hash img (8-bit gray, BGR or BGRA). The thumbnails are reused from
+   * call to call. */
+  FrameHash Compute(const cv::Mat& img);
+
+ private:
+  cv::Mat small_;
+  cv::Mat gray_;
+};
+
+}  // namespace textile
+
+#endif  // TEXTILE_FRAME_HASH_HPP_
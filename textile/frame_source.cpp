@@ -0,0 +1,30 @@
+#include "textile/frame_source.hpp"
+
+#include <memory>
+
+#include <glog/logging.h>
+
+#ifdef USE_GSTREAMER
+#include "textile/gst_stream.hpp"
+#endif  // USE_GSTREAMER
+#include "textile/rtsp_stream.hpp"
+
+namespace textile {
+
+std::unique_ptr<FrameSource> CreateFrameSource(const CameraConfig& camera) {
+  if (camera.backend == "gstreamer") {
+#ifdef USE_GSTREAMER
+    std::unique_ptr<GstStream> stream(new GstStream());
+    stream->Init(camera);
+    return std::unique_ptr<FrameSource>(stream.release());
+#else
+    LOG(FATAL) << "camera " << camera.name << ": backend gstreamer needs a"
+               << " build with TEXTILE_GSTREAMER=ON";
+#endif  // USE_GSTREAMER
+  }
+  std::unique_ptr<RTSP_Stream> stream(new RTSP_Stream());
+  stream->Init(camera);
+  return std::unique_ptr<FrameSource>(stream.release());
+}
+
+}  // namespace textile
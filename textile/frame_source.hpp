@@ -0,0 +1,66 @@
+// Where the frames of a camera come from.
+//
+// A FrameSource hands out decoded frames one at a time. A frame may point
+// into memory the backend lends out (e.g. a mapped GStreamer buffer)
+// instead of a copy; such a frame stays valid until it is released or the
+// next one is read into it, and a backend only lends a few at a time, so
+// callers release frames as soon as they are done with them.
+//
+#ifndef TEXTILE_FRAME_SOURCE_HPP_
+#define TEXTILE_FRAME_SOURCE_HPP_
+
+#include <stdint.h>
+
+#include <memory>
+
+#include <opencv2/core/core.hpp>
+
+#include "textile/config.hpp"
+
+namespace textile {
+
+struct Frame {
+  Frame() : corrupt(false), timestamp_us(0) {}
+
+  /* Hand the pixels back to the source. */
+  void Release() {
+    image = cv::Mat();
+    owner.reset();
+    corrupt = false;
+    timestamp_us = 0;
+  }
+
+  cv::Mat image;
+  /* Keeps the memory behind image alive, if the source lends it. */
+  std::shared_ptr<void> owner;
+  /* The decoder reported errors in this frame or in a frame it is
+   * predicted from (e.g. after lost packets), so parts of it may be smeared
+   * or stale. Only sources whose decoder reports errors set it. */
+  bool corrupt;
+  /* When the frame was taken, in microseconds since the epoch: from the
+   * sender's NTP clock if the source has it, else the stream's PTS mapped
+   * to the wall clock (see stream_clock.hpp). */
+  int64_t timestamp_us;
+};
+
+class FrameSource {
+ public:
+  virtual ~FrameSource() {}
+
+  virtual void Open() = 0;
+
+  /* Close the stream and open it again. */
+  virtual void Reconnect() = 0;
+
+  /* Release frame and replace it with the next one; frame->image is empty
+   * if there is none. */
+  virtual void Read(Frame* frame) = 0;
+};
+
+/* The source for camera, with the backend its config asks for (not yet
+ * opened). Dies if that backend was not built in. */
+std::unique_ptr<FrameSource> CreateFrameSource(const CameraConfig& camera);
+
+}  // namespace textile
+
+#endif  // TEXTILE_FRAME_SOURCE_HPP_
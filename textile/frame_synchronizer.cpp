@@ -0,0 +1,86 @@
+#include "textile/frame_synchronizer.hpp"
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+namespace textile {
+
+FrameSynchronizer::FrameSynchronizer(int64_t tolerance_us,
+                                     int64_t max_wait_us)
+    : tolerance_us_(tolerance_us), max_wait_us_(max_wait_us), groups_(0),
+      complete_(0), last_skew_us_(0) {
+  CHECK_GE(tolerance_us, 0);
+  CHECK_GE(max_wait_us, 0);
+}
+
+int FrameSynchronizer::AddStream() {
+  streams_.push_back(Stream());
+  return static_cast<int>(streams_.size()) - 1;
+}
+
+void FrameSynchronizer::Seen(int stream, int64_t timestamp_us) {
+  Stream& s = streams_[stream];
+  s.seen_us = std::max(s.seen_us, timestamp_us);
+}
+
+void FrameSynchronizer::Push(int stream, int64_t timestamp_us) {
+  Stream& s = streams_[stream];
+  // Out of order: the frame is grouped as if taken with the last one.
+  if (!s.queued.empty()) {
+    timestamp_us = std::max(timestamp_us, s.queued.back());
+  }
+  s.queued.push_back(timestamp_us);
+  Seen(stream, timestamp_us);
+}
+
+bool FrameSynchronizer::Pop(int64_t now_us, std::vector<int>* members) {
+  members->clear();
+  int first = -1;
+  for (size_t i = 0; i < streams_.size(); ++i) {
+    if (!streams_[i].queued.empty() &&
+        (first < 0 ||
+         streams_[i].queued.front() < streams_[first].queued.front())) {
+      first = static_cast<int>(i);
+    }
+  }
+  if (first < 0) {
+    return false;
+  }
+  const int64_t start = streams_[first].queued.front();
+  const int64_t end = start + tolerance_us_;
+  const bool timed_out = now_us > end + max_wait_us_;
+  int64_t last = start;
+  for (size_t i = 0; i < streams_.size(); ++i) {
+    const Stream& s = streams_[i];
+    if (!s.queued.empty() && s.queued.front() <= end) {
+      members->push_back(static_cast<int>(i));
+      last = std::max(last, s.queued.front());
+    } else if (s.seen_us < end && !timed_out) {
+      // A frame of this stream may still fall in the window.
+      members->clear();
+      return false;
+    }
+  }
+  for (size_t i = 0; i < members->size(); ++i) {
+    streams_[(*members)[i]].queued.pop_front();
+  }
+  ++groups_;
+  if (members->size() == streams_.size()) {
+    ++complete_;
+  }
+  last_skew_us_ = last - start;
+  return true;
+}
+
+void FrameSynchronizer::Export(const std::string& name,
+                               Metrics* metrics) const {
+  const std::string label = "{rig=\"" + name + "\"}";
+  metrics->Set("textile_sync_groups_total" + label,
+               static_cast<double>(groups_));
+  metrics->Set("textile_sync_complete_ratio" + label,
+               groups_ > 0 ? static_cast<double>(complete_) / groups_ : 0.);
+  metrics->Set("textile_sync_skew_ms" + label, last_skew_us_ / 1000.);
+}
+
+}  // namespace textile
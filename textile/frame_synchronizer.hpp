@@ -0,0 +1,73 @@
+// Groups of frames of several streams taken at the same moment.
+//
+// Each stream queues the frames it wants grouped, in timestamp order, and
+// reports every other frame it reads as seen. A group is the oldest queued
+// frame with, from each other stream, its oldest queued frame within
+// tolerance after it. The group is final once every stream has either a
+// frame in it or has seen a frame later than its window -- its later frames
+// can only be later still -- or when max_wait has passed since the window
+// closed, for a stream that stalled. So frames wait for their partners
+// only as long as a partner may still come, normally less than one round
+// of reads.
+//
+// The synchronizer only keeps timestamps; callers keep the frames in queues
+// of their own in the same order and take the first of each member stream
+// for a group.
+//
+#ifndef TEXTILE_FRAME_SYNCHRONIZER_HPP_
+#define TEXTILE_FRAME_SYNCHRONIZER_HPP_
+
+#include <stdint.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "textile/metrics.hpp"
+
+namespace textile {
+
+class FrameSynchronizer {
+ public:
+  /* Frames within tolerance_us of the first of a group join it; a group
+   * waits for a missing stream until max_wait_us after its window. */
+  FrameSynchronizer(int64_t tolerance_us, int64_t max_wait_us);
+
+  /* Add a stream; returns its index. */
+  int AddStream();
+
+  /* Stream read a frame taken at timestamp_us that is not to be grouped. */
+  void Seen(int stream, int64_t timestamp_us);
+  /* Queue a frame of stream taken at timestamp_us. */
+  void Push(int stream, int64_t timestamp_us);
+
+  /* Take the next final group at wall time now_us: members gets its
+   * streams, each to take its oldest queued frame. Returns false while
+   * there is none. */
+  bool Pop(int64_t now_us, std::vector<int>* members);
+
+  /* Set textile_sync_groups_total, textile_sync_complete_ratio (groups with
+   * a frame of every stream) and textile_sync_skew_ms (of the last group)
+   * for the rig name. */
+  void Export(const std::string& name, Metrics* metrics) const;
+
+ private:
+  struct Stream {
+    Stream() : seen_us(INT64_MIN) {}
+
+    std::deque<int64_t> queued;
+    /* The latest timestamp read, queued or not. */
+    int64_t seen_us;
+  };
+
+  int64_t tolerance_us_;
+  int64_t max_wait_us_;
+  std::vector<Stream> streams_;
+  int64_t groups_;
+  int64_t complete_;
+  int64_t last_skew_us_;
+};
+
+}  // namespace textile
+
+#endif  // TEXTILE_FRAME_SYNCHRONIZER_HPP_
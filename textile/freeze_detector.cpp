@@ -0,0 +1,51 @@
+#include "textile/freeze_detector.hpp"
+
+#include <vector>
+
+#include <glog/logging.h>
+
+namespace textile {
+
+uint64_t SampledFrameHash(const cv::Mat& img, int step) {
+  uint64_t hash = 14695981039346656037ULL;
+  const int pixel = static_cast<int>(img.elemSize());
+  for (int y = 0; y < img.rows; y += step) {
+    const uint8_t* row = img.ptr<uint8_t>(y);
+    for (int x = 0; x < img.cols; x += step) {
+      const uint8_t* p = row + x * pixel;
+      for (int c = 0; c < pixel; ++c) {
+        hash = (hash ^ p[c]) * 1099511628211ULL;
+      }
+    }
+  }
+  return hash;
+}
+
+FreezeDetector::FreezeDetector(int history, int frozen_after)
+    : frozen_after_(frozen_after), history_(history), size_(0), next_(0),
+      repeats_(0) {
+  CHECK_GT(history, 0);
+  CHECK_GT(frozen_after, 0);
+}
+
+bool FreezeDetector::Add(uint64_t hash) {
+  bool repeat = false;
+  for (int i = 0; i < size_ && !repeat; ++i) {
+    repeat = history_[i] == hash;
+  }
+  repeats_ = repeat ? repeats_ + 1 : 0;
+  history_[next_] = hash;
+  next_ = (next_ + 1) % static_cast<int>(history_.size());
+  if (size_ < static_cast<int>(history_.size())) {
+    ++size_;
+  }
+  return repeat;
+}
+
+void FreezeDetector::Reset() {
+  size_ = 0;
+  next_ = 0;
+  repeats_ = 0;
+}
+
+}  // namespace textile
@@ -0,0 +1,51 @@
+// Detection of frozen streams.
+//
+// When a camera or its encoder hangs, the RTSP stream often goes on
+// delivering the same picture. Live frames always differ somewhere because
+// of sensor noise, so a repeat is recognised by an exact hash of a sparse
+// grid of pixels matching one of the last few frames. Repeated frames are
+// not worth a forward pass; after frozen_after of them in a row the stream
+// is considered frozen.
+//
+#ifndef TEXTILE_FREEZE_DETECTOR_HPP_
+#define TEXTILE_FREEZE_DETECTOR_HPP_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+namespace textile {
+
+/* FNV-1a hash of the pixels of img on a grid of step x step. */
+uint64_t SampledFrameHash(const cv::Mat& img, int step);
+
+class FreezeDetector {
+ public:
+  /* Compare each frame with the last history ones. */
+  FreezeDetector(int history, int frozen_after);
+
+  /* Add the hash of the next frame; returns whether it repeats one of the
+   * previous frames. */
+  bool Add(uint64_t hash);
+
+  /* Frames repeated in a row. */
+  int repeats() const { return repeats_; }
+  bool frozen() const { return repeats_ >= frozen_after_; }
+
+  /* Forget the history, e.g. after reconnecting. */
+  void Reset();
+
+ private:
+  int frozen_after_;
+  /* Ring of the last hashes. */
+  std::vector<uint64_t> history_;
+  int size_;
+  int next_;
+  int repeats_;
+};
+
+}  // namespace textile
+
+#endif  // TEXTILE_FREEZE_DETECTOR_HPP_
@@ -0,0 +1,200 @@
+#include "textile/gst_stream.hpp"
+
+#include <gst/app/gstappsink.h>
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+#include <glog/logging.h>
+
+namespace textile {
+
+/* How long Read waits for a frame before giving up. */
+static const GstClockTime kPullTimeout = 2 * GST_SECOND;
+/* Frames the appsink queues with drop = none. */
+static const int kQueuedFrames = 4;
+/* Seconds from the NTP epoch (1900) to the Unix one. */
+static const int64_t kNtpToUnixSeconds = 2208988800LL;
+
+/* A pulled sample, mapped for reading for as long as a Frame refers to
+ * it. */
+struct MappedSample {
+  MappedSample(GstSample* s, GstBuffer* b, const GstMapInfo& m)
+      : sample(s), buffer(b), map(m) {}
+  ~MappedSample() {
+    gst_buffer_unmap(buffer, &map);
+    gst_sample_unref(sample);
+  }
+
+  GstSample* sample;
+  GstBuffer* buffer;
+  GstMapInfo map;
+};
+
+static void InitGStreamer() {
+  static std::once_flag once;
+  std::call_once(once, [] { gst_init(NULL, NULL); });
+}
+
+GstStream::GstStream() : pipeline_(NULL), sink_(NULL) {}
+
+GstStream::~GstStream() {
+  Close();
+}
+
+void GstStream::Init(const CameraConfig& camera) {
+  name_ = camera.name;
+  std::ostringstream description;
+  description << "rtspsrc location=\"" << camera.url << "\" latency="
+              << camera.latency_ms;
+  if (!camera.transport.empty()) {
+    description << " protocols=" << camera.transport;
+  }
+  if (camera.low_delay) {
+    // Late packets are dropped rather than waited for.
+    description << " drop-on-latency=true";
+  }
+  if (camera.ntp_timestamps) {
+    description << " add-reference-timestamp-meta=true";
+  }
+  description << " ! rtp" << camera.codec << "depay ! "
+              << camera.codec << "parse ! avdec_" << camera.codec
+              << " ! videoconvert ! videoscale ! video/x-raw,format=BGR";
+  if (camera.scale_width > 0) {
+    description << ",width=" << camera.scale_width << ",height="
+                << camera.scale_height;
+  }
+  description << " ! appsink name=sink sync=false ";
+  if (camera.drop == "latest") {
+    description << "max-buffers=1 drop=true";
+  } else {
+    description << "max-buffers=" << kQueuedFrames << " drop=false";
+  }
+  description_ = description.str();
+}
+
+void GstStream::Open() {
+  InitGStreamer();
+  GError* error = NULL;
+  pipeline_ = gst_parse_launch(description_.c_str(), &error);
+  if (error != NULL) {
+    LOG(ERROR) << name_ << ": can't build the pipeline: " << error->message;
+    g_error_free(error);
+    Close();
+    return;
+  }
+  sink_ = gst_bin_get_by_name(GST_BIN(pipeline_), "sink");
+  if (gst_element_set_state(pipeline_, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE) {
+    PollBus();
+    LOG(ERROR) << name_ << ": can't start the pipeline";
+  }
+}
+
+void GstStream::Close() {
+  // Frames still lent out keep their buffers; only the pipeline goes.
+  if (pipeline_ != NULL) {
+    gst_element_set_state(pipeline_, GST_STATE_NULL);
+  }
+  if (sink_ != NULL) {
+    gst_object_unref(sink_);
+    sink_ = NULL;
+  }
+  if (pipeline_ != NULL) {
+    gst_object_unref(pipeline_);
+    pipeline_ = NULL;
+  }
+}
+
+void GstStream::Reconnect() {
+  Close();
+  clock_.Reset();
+  Open();
+}
+
+bool GstStream::PollBus() {
+  if (pipeline_ == NULL) {
+    return true;
+  }
+  GstBus* bus = gst_element_get_bus(pipeline_);
+  bool failed = false;
+  GstMessage* message;
+  while ((message = gst_bus_pop_filtered(bus, static_cast<GstMessageType>(
+              GST_MESSAGE_ERROR | GST_MESSAGE_EOS))) != NULL) {
+    if (GST_MESSAGE_TYPE(message) == GST_MESSAGE_ERROR) {
+      GError* error = NULL;
+      gchar* debug = NULL;
+      gst_message_parse_error(message, &error, &debug);
+      LOG(WARNING) << name_ << ": " << error->message
+                   << (debug != NULL ? std::string(" (") + debug + ")" : "");
+      g_error_free(error);
+      g_free(debug);
+    } else {
+      LOG(WARNING) << name_ << ": end of stream";
+    }
+    failed = true;
+    gst_message_unref(message);
+  }
+  gst_object_unref(bus);
+  return failed;
+}
+
+void GstStream::Read(Frame* frame) {
+  frame->Release();
+  if (sink_ == NULL) {
+    LOG(WARNING) << "Can't get frame: " << name_ << " is not open";
+    return;
+  }
+  GstSample* sample =
+      gst_app_sink_try_pull_sample(GST_APP_SINK(sink_), kPullTimeout);
+  if (sample == NULL) {
+    PollBus();
+    LOG(WARNING) << "Can't get frame: " << name_;
+    return;
+  }
+  GstVideoInfo info;
+  GstCaps* caps = gst_sample_get_caps(sample);
+  GstBuffer* buffer = gst_sample_get_buffer(sample);
+  GstMapInfo map;
+  if (caps == NULL || buffer == NULL ||
+      !gst_video_info_from_caps(&info, caps) ||
+      !gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+    LOG(WARNING) << "Can't map frame: " << name_;
+    gst_sample_unref(sample);
+    return;
+  }
+  std::shared_ptr<MappedSample> mapped(new MappedSample(sample, buffer, map));
+  // Read only: the buffer may be shared with the rest of the pipeline.
+  frame->image = cv::Mat(GST_VIDEO_INFO_HEIGHT(&info),
+                         GST_VIDEO_INFO_WIDTH(&info), CV_8UC3, map.data,
+                         GST_VIDEO_INFO_PLANE_STRIDE(&info, 0));
+  frame->owner = mapped;
+  // avdec outputs the frames FFmpeg flags as corrupt (output-corrupt
+  // defaults to true) and marks their buffers; these include the frames
+  // predicted from a damaged one, up to the next keyframe.
+  frame->corrupt = GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_CORRUPTED);
+  frame->timestamp_us = Timestamp(buffer);
+}
+
+int64_t GstStream::Timestamp(GstBuffer* buffer) {
+  static GstCaps* const ntp_caps =
+      gst_caps_new_empty_simple("timestamp/x-ntp");
+  const int64_t arrival = WallTimeUs();
+  GstReferenceTimestampMeta* meta =
+      gst_buffer_get_reference_timestamp_meta(buffer, ntp_caps);
+  if (meta != NULL) {
+    return static_cast<int64_t>(meta->timestamp / GST_USECOND) -
+        kNtpToUnixSeconds * 1000000LL;
+  }
+  if (!GST_BUFFER_PTS_IS_VALID(buffer)) {
+    return arrival;
+  }
+  return clock_.ToWall(
+      static_cast<int64_t>(GST_BUFFER_PTS(buffer) / GST_USECOND), arrival);
+}
+
+}  // namespace textile
@@ -0,0 +1,69 @@
+// RTSP camera source built on a GStreamer pipeline.
+//
+//    rtspsrc latency=<latency_ms> [protocols=<transport>]
+//        [drop-on-latency=true] [add-reference-timestamp-meta=true]
+//        ! rtph264depay ! h264parse ! avdec_h264
+//        ! videoconvert ! videoscale ! video/x-raw,format=BGR[,width,height]
+//        ! appsink max-buffers=... drop=...
+//
+// Unlike cv::VideoCapture, the buffering is explicit: rtspsrc keeps
+// latency_ms of jitter buffer and the appsink either keeps only the newest
+// frame (drop = latest) or queues a few and holds the pipeline back (drop =
+// none). Frames are not copied out of GStreamer: the sample pulled from the
+// appsink is mapped and wrapped as the cv::Mat of the Frame, and goes back
+// to the pipeline when the Frame is released. Frames the decoder flags as
+// corrupt are handed out marked Frame::corrupt rather than dropped.
+//
+// With ntp_timestamps, rtspsrc attaches to every buffer the NTP time the
+// camera took it at, from the RTCP sender reports, which becomes the
+// frame's timestamp. Without it, or before the first report, the PTS is
+// mapped to the wall clock by a StreamClock.
+//
+#ifndef TEXTILE_GST_STREAM_HPP_
+#define TEXTILE_GST_STREAM_HPP_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "textile/config.hpp"
+#include "textile/frame_source.hpp"
+#include "textile/stream_clock.hpp"
+
+typedef struct _GstBuffer GstBuffer;
+typedef struct _GstElement GstElement;
+
+namespace textile {
+
+class GstStream : public FrameSource {
+ public:
+  GstStream();
+  virtual ~GstStream();
+
+  /* Build the pipeline description from the camera's config. */
+  void Init(const CameraConfig& camera);
+
+  virtual void Open();
+  virtual void Reconnect();
+  virtual void Read(Frame* frame);
+
+  const std::string& pipeline_description() const { return description_; }
+
+ private:
+  void Close();
+  /* Log the pipeline's error messages; returns whether there were any or
+   * the stream ended. */
+  bool PollBus();
+  /* The capture time of a frame, in microseconds since the epoch. */
+  int64_t Timestamp(GstBuffer* buffer);
+
+  std::string name_;
+  std::string description_;
+  GstElement* pipeline_;
+  GstElement* sink_;
+  StreamClock clock_;
+};
+
+}  // namespace textile
+
+#endif  // TEXTILE_GST_STREAM_HPP_
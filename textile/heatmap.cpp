@@ -0,0 +1,90 @@
+#include "textile/heatmap.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+#include <glog/logging.h>
+
+namespace textile {
+
+Heatmap::Heatmap(int cols, int rows)
+    : cols_(cols), rows_(rows), cells_(cols * rows, 0) {
+  CHECK(cols > 0 && rows > 0) << "Empty heatmap grid";
+}
+
+void Heatmap::Add(float x, float y) {
+  const int col = std::min(std::max(static_cast<int>(x * cols_), 0),
+                           cols_ - 1);
+  const int row = std::min(std::max(static_cast<int>(y * rows_), 0),
+                           rows_ - 1);
+  ++cells_[row * cols_ + col];
+}
+
+void Heatmap::Export(const std::string& camera, Metrics* metrics) const {
+  for (int row = 0; row < rows_; ++row) {
+    for (int col = 0; col < cols_; ++col) {
+      const int64_t n = cells_[row * cols_ + col];
+      if (n == 0) {
+        continue;
+      }
+      std::ostringstream name;
+      name << "textile_heatmap_detections{camera=\"" << camera
+           << "\",col=\"" << col << "\",row=\"" << row << "\"}";
+      metrics->Set(name.str(), static_cast<double>(n));
+    }
+  }
+}
+
+DefectDensity::DefectDensity(double bin_metres, int num_bins)
+    : bin_metres_(bin_metres), bins_(num_bins, 0), head_(0), completed_(0),
+      window_sum_(0), total_(0), position_(0.), head_start_(0.) {
+  CHECK_GT(bin_metres, 0.);
+  CHECK_GT(num_bins, 1);
+}
+
+void DefectDensity::Advance(double metres) {
+  if (metres <= 0.) {
+    return;
+  }
+  position_ += metres;
+  const int num_bins = static_cast<int>(bins_.size());
+  // A jump past the whole window clears it at once.
+  if (position_ - head_start_ >= num_bins * bin_metres_) {
+    std::fill(bins_.begin(), bins_.end(), 0);
+    window_sum_ = 0;
+    completed_ = num_bins - 1;
+    head_start_ += static_cast<int64_t>((position_ - head_start_) /
+                                        bin_metres_) * bin_metres_;
+    return;
+  }
+  while (position_ - head_start_ >= bin_metres_) {
+    head_start_ += bin_metres_;
+    head_ = (head_ + 1) % num_bins;
+    // The new head is the oldest bin of the ring.
+    window_sum_ -= bins_[head_];
+    bins_[head_] = 0;
+    completed_ = std::min(completed_ + 1, num_bins - 1);
+  }
+}
+
+void DefectDensity::Add(int count) {
+  bins_[head_] += count;
+  window_sum_ += count;
+  total_ += count;
+}
+
+double DefectDensity::PerMetre() const {
+  const double length = completed_ * bin_metres_ + (position_ - head_start_);
+  return length > 0. ? window_sum_ / length : 0.;
+}
+
+void DefectDensity::Export(const std::string& camera,
+                           Metrics* metrics) const {
+  const std::string label = "{camera=\"" + camera + "\"}";
+  metrics->Set("textile_fabric_position_metres" + label, position_);
+  metrics->Set("textile_defects_total" + label, static_cast<double>(total_));
+  metrics->Set("textile_defects_per_metre" + label, PerMetre());
+}
+
+}  // namespace textile
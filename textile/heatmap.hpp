@@ -0,0 +1,81 @@
+// Running spatial and per-metre defect statistics of a camera.
+//
+// Heatmap counts detection centres on a coarse grid over the frame.
+// DefectDensity follows the fabric as it moves past the camera: the fabric
+// is cut into bins of fixed length held in a ring, each new defect is added
+// to the bin under the camera, and the ring keeps a running sum, so both
+// updates and the rolling density are O(1).
+//
+// Both are exported through Metrics, so trends are visible without
+// rescanning the logs.
+//
+#ifndef TEXTILE_HEATMAP_HPP_
+#define TEXTILE_HEATMAP_HPP_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "textile/metrics.hpp"
+
+namespace textile {
+
+class Heatmap {
+ public:
+  Heatmap(int cols, int rows);
+
+  /* Count a detection centred at (x, y), in [0, 1) of the frame size. */
+  void Add(float x, float y);
+
+  int cols() const { return cols_; }
+  int rows() const { return rows_; }
+  int64_t count(int col, int row) const { return cells_[row * cols_ + col]; }
+
+  /* Set textile_heatmap_detections{camera,col,row} for the non-empty
+   * cells. */
+  void Export(const std::string& camera, Metrics* metrics) const;
+
+ private:
+  int cols_;
+  int rows_;
+  std::vector<int64_t> cells_;
+};
+
+class DefectDensity {
+ public:
+  /* Keep the last num_bins * bin_metres of fabric. */
+  DefectDensity(double bin_metres, int num_bins);
+
+  /* The fabric moved by metres. */
+  void Advance(double metres);
+
+  /* count defects seen at the current position. */
+  void Add(int count);
+
+  /* Metres of fabric seen so far. */
+  double position() const { return position_; }
+  int64_t total() const { return total_; }
+
+  /* Defects per metre over the window (or the fabric seen so far, if
+   * shorter). */
+  double PerMetre() const;
+
+  void Export(const std::string& camera, Metrics* metrics) const;
+
+ private:
+  double bin_metres_;
+  /* Ring of per-bin counts; head_ is the bin under the camera. */
+  std::vector<int32_t> bins_;
+  int head_;
+  /* Completed bins in the ring, at most bins_.size() - 1. */
+  int completed_;
+  int64_t window_sum_;
+  int64_t total_;
+  double position_;
+  double head_start_;
+};
+
+}  // namespace textile
+
+#endif  // TEXTILE_HEATMAP_HPP_
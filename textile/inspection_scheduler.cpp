@@ -0,0 +1,68 @@
+#include "textile/inspection_scheduler.hpp"
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+namespace textile {
+
+InspectionScheduler::InspectionScheduler(double overlap, double max_gap)
+    : overlap_(overlap), max_gap_(max_gap), metres_(0.), seconds_(0.),
+      last_metres_(0.), inspected_(0), skipped_(0), passed_(0.),
+      covered_(0.) {
+  CHECK(overlap >= 0. && overlap < 1.) << "Bad overlap " << overlap;
+  CHECK_GE(max_gap, 0.);
+}
+
+void InspectionScheduler::Advance(double metres, double seconds) {
+  metres_ += metres;
+  seconds_ += seconds;
+  last_metres_ = metres;
+  passed_ += metres;
+}
+
+bool InspectionScheduler::Inspect(double fov) {
+  // Wait for as long as the next frame would still overlap enough.
+  const double step = fov * (1. - overlap_);
+  const bool inspect = inspected_ == 0 || fov <= 0. ||
+      metres_ + last_metres_ > step ||
+      (max_gap_ > 0. && seconds_ >= max_gap_);
+  if (!inspect) {
+    ++skipped_;
+    return false;
+  }
+  // Fabric further than a view behind went by between two inspections.
+  if (inspected_ > 0) {
+    covered_ += std::min(metres_, std::max(fov, 0.));
+  } else {
+    passed_ -= metres_;
+  }
+  ++inspected_;
+  metres_ = 0.;
+  seconds_ = 0.;
+  return true;
+}
+
+double InspectionScheduler::Coverage() const {
+  // The fabric since the last inspected frame is still to be seen.
+  const double seen = passed_ - metres_;
+  return seen > 0. ? covered_ / seen : 1.;
+}
+
+double InspectionScheduler::Saved() const {
+  const int64_t frames = inspected_ + skipped_;
+  return frames > 0 ? static_cast<double>(skipped_) / frames : 0.;
+}
+
+void InspectionScheduler::Export(const std::string& camera,
+                                 Metrics* metrics) const {
+  const std::string label = "{camera=\"" + camera + "\"}";
+  metrics->Set("textile_frames_inspected_total" + label,
+               static_cast<double>(inspected_));
+  metrics->Set("textile_frames_skipped_total" + label,
+               static_cast<double>(skipped_));
+  metrics->Set("textile_inspection_coverage_ratio" + label, Coverage());
+  metrics->Set("textile_inspection_saved_ratio" + label, Saved());
+}
+
+}  // namespace textile
@@ -0,0 +1,69 @@
+// Which frames of a camera to inspect, from how far the fabric moved.
+//
+// A camera runs at a fixed frame rate while the line runs anywhere from
+// stopped to fast, so a fixed sample_every either inspects the same fabric
+// many times over or leaves gaps. Each frame shows fov metres of fabric;
+// the scheduler inspects a frame once the next one would have moved more
+// than fov * (1 - overlap) past the last inspected frame, so consecutive
+// inspected frames share at least overlap of their view while as many
+// frames as possible are skipped. While the line stands still a frame is
+// still inspected every max_gap seconds.
+//
+// It also keeps how much of the fabric the inspected frames covered and
+// how many frames it skipped, exported through Metrics.
+//
+#ifndef TEXTILE_INSPECTION_SCHEDULER_HPP_
+#define TEXTILE_INSPECTION_SCHEDULER_HPP_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "textile/metrics.hpp"
+
+namespace textile {
+
+class InspectionScheduler {
+ public:
+  /* overlap is the fraction of the view in [0, 1) consecutive inspected
+   * frames share; max_gap the seconds between inspections at most, 0 for
+   * no limit. */
+  InspectionScheduler(double overlap, double max_gap);
+
+  /* The fabric moved metres in the seconds since the previous frame. Call
+   * for every frame read, whether or not it is considered for inspection. */
+  void Advance(double metres, double seconds);
+
+  /* Whether to inspect the current frame, showing fov metres of fabric
+   * along its motion. Counts the frame as inspected or skipped. */
+  bool Inspect(double fov);
+
+  int64_t inspected() const { return inspected_; }
+  int64_t skipped() const { return skipped_; }
+  /* Fraction of the fabric moved past the camera that was in the view of
+   * an inspected frame; 1 before it moved at all. */
+  double Coverage() const;
+  /* Fraction of the frames considered that were skipped. */
+  double Saved() const;
+
+  void Export(const std::string& camera, Metrics* metrics) const;
+
+ private:
+  double overlap_;
+  double max_gap_;
+  /* Fabric moved and time passed since the last inspected frame, and by
+   * the last frame alone: the best guess for the next one. */
+  double metres_;
+  double seconds_;
+  double last_metres_;
+  int64_t inspected_;
+  int64_t skipped_;
+  /* Metres moved past the camera, and those of them an inspected frame
+   * showed. */
+  double passed_;
+  double covered_;
+};
+
+}  // namespace textile
+
+#endif  // TEXTILE_INSPECTION_SCHEDULER_HPP_
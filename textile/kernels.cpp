@@ -0,0 +1,221 @@
+#include "textile/kernels.hpp"
+
+#include <string.h>
+
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace textile {
+
+static void HwcToPlanarScalar(const uint8_t* src, int width, int height,
+                              int src_stride, int channels,
+                              const float* mean, float* dst) {
+  const int plane = width * height;
+  for (int y = 0; y < height; ++y) {
+    const uint8_t* row = src + y * src_stride;
+    float* out = dst + y * width;
+    for (int x = 0; x < width; ++x) {
+      for (int c = 0; c < channels; ++c) {
+        out[c * plane + x] = row[x * channels + c] - mean[c];
+      }
+    }
+  }
+}
+
+static void IouRowScalar(float xmin, float ymin, float xmax, float ymax,
+                         float area, const float* xmins, const float* ymins,
+                         const float* xmaxs, const float* ymaxs,
+                         const float* areas, int n, float* iou) {
+  for (int j = 0; j < n; ++j) {
+    float w = (xmaxs[j] < xmax ? xmaxs[j] : xmax) -
+              (xmins[j] > xmin ? xmins[j] : xmin);
+    float h = (ymaxs[j] < ymax ? ymaxs[j] : ymax) -
+              (ymins[j] > ymin ? ymins[j] : ymin);
+    w = w > 0.f ? w : 0.f;
+    h = h > 0.f ? h : 0.f;
+    const float inter = w * h;
+    const float sum = area + areas[j];
+    const float uni = sum - inter;
+    iou[j] = uni > 0.f ? inter / uni : 0.f;
+  }
+}
+
+static void AccumulateRowsScalar(const uint8_t* src, int src_stride,
+                                 int rows, int n, uint16_t* acc) {
+  for (int r = 0; r < rows; ++r) {
+    const uint8_t* row = src + static_cast<int64_t>(r) * src_stride;
+    for (int i = 0; i < n; ++i) {
+      acc[i] = static_cast<uint16_t>(acc[i] + row[i]);
+    }
+  }
+}
+
+static void AbsDiffScalar(const uint8_t* a, const uint8_t* b, int n,
+                          uint8_t* diff, uint64_t* sad, uint64_t* ssd) {
+  for (int i = 0; i < n; ++i) {
+    const int d = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+    diff[i] = static_cast<uint8_t>(d);
+    *sad += d;
+    *ssd += d * d;
+  }
+}
+
+const Kernels kScalarKernels = {
+  kCpuScalar,
+  HwcToPlanarScalar,
+  IouRowScalar,
+  AccumulateRowsScalar,
+  AbsDiffScalar,
+};
+
+const Kernels* KernelsForLevel(CpuLevel level) {
+  if (level > DetectCpuLevel()) {
+    return NULL;
+  }
+  switch (level) {
+    case kCpuScalar:
+      return &kScalarKernels;
+#ifdef TEXTILE_HAVE_SSE42
+    case kCpuSSE42:
+      return &kSSE42Kernels;
+#endif
+#ifdef TEXTILE_HAVE_AVX2
+    case kCpuAVX2:
+      return &kAVX2Kernels;
+#endif
+#ifdef TEXTILE_HAVE_AVX512
+    case kCpuAVX512:
+      return &kAVX512Kernels;
+#endif
+    default:
+      return NULL;
+  }
+}
+
+const Kernels& GetKernels() {
+  // Fall back level by level to the best variant that was compiled in.
+  for (int level = ActiveCpuLevel(); level > kCpuScalar; --level) {
+    const Kernels* kernels = KernelsForLevel(static_cast<CpuLevel>(level));
+    if (kernels != NULL) {
+      return *kernels;
+    }
+  }
+  return kScalarKernels;
+}
+
+static bool VerifyHwcToPlanar(const Kernels& kernels, std::ostream* report) {
+  // Odd sizes and a padded stride exercise the vector tails.
+  const int width = 301, height = 7, stride = 301 * 3 + 5;
+  const float mean[3] = { 104.f, 117.f, 123.f };
+  std::vector<uint8_t> src(stride * height);
+  for (size_t i = 0; i < src.size(); ++i) {
+    src[i] = static_cast<uint8_t>(rand());
+  }
+  bool ok = true;
+  for (int channels = 1; channels <= 3; channels += 2) {
+    std::vector<float> expected(channels * width * height);
+    std::vector<float> actual(expected.size());
+    kScalarKernels.hwc_to_planar(&src[0], width, height, stride, channels,
+                                 mean, &expected[0]);
+    kernels.hwc_to_planar(&src[0], width, height, stride, channels, mean,
+                          &actual[0]);
+    const bool same = memcmp(&expected[0], &actual[0],
+                             expected.size() * sizeof(float)) == 0;
+    *report << "hwc_to_planar/" << channels << "ch "
+            << CpuLevelName(kernels.level) << ": "
+            << (same ? "identical" : "MISMATCH") << "\n";
+    ok = ok && same;
+  }
+  return ok;
+}
+
+static bool VerifyIouRow(const Kernels& kernels, std::ostream* report) {
+  // An odd count exercises the vector tails; boxes are in a small area so
+  // that most pairs overlap, and some are empty.
+  const int n = 203;
+  std::vector<float> xmins(n), ymins(n), xmaxs(n), ymaxs(n), areas(n);
+  for (int j = 0; j < n; ++j) {
+    xmins[j] = static_cast<float>(rand() % 1000) / 10.f;
+    ymins[j] = static_cast<float>(rand() % 1000) / 10.f;
+    xmaxs[j] = xmins[j] + static_cast<float>(rand() % 500) / 10.f;
+    ymaxs[j] = ymins[j] + static_cast<float>(rand() % 500) / 10.f;
+    areas[j] = (xmaxs[j] - xmins[j]) * (ymaxs[j] - ymins[j]);
+  }
+  std::vector<float> expected(n), actual(n);
+  bool same = true;
+  for (int i = 0; i < n && same; ++i) {
+    kScalarKernels.iou_row(xmins[i], ymins[i], xmaxs[i], ymaxs[i], areas[i],
+                           &xmins[0], &ymins[0], &xmaxs[0], &ymaxs[0],
+                           &areas[0], n, &expected[0]);
+    kernels.iou_row(xmins[i], ymins[i], xmaxs[i], ymaxs[i], areas[i],
+                    &xmins[0], &ymins[0], &xmaxs[0], &ymaxs[0], &areas[0],
+                    n, &actual[0]);
+    same = memcmp(&expected[0], &actual[0], n * sizeof(float)) == 0;
+  }
+  *report << "iou_row " << CpuLevelName(kernels.level) << ": "
+          << (same ? "identical" : "MISMATCH") << "\n";
+  return same;
+}
+
+static bool VerifyAccumulateRows(const Kernels& kernels,
+                                 std::ostream* report) {
+  const int n = 1000 + 37, stride = n + 11, rows = 300;
+  std::vector<uint8_t> src(stride * rows);
+  for (size_t i = 0; i < src.size(); ++i) {
+    src[i] = static_cast<uint8_t>(rand());
+  }
+  std::vector<uint16_t> expected(n), actual(n);
+  bool same = true;
+  // Bands of 1 to 5 rows; enough of them that some sums wrap around, as a
+  // caller must not let them.
+  for (int row = 0; row + 5 <= rows && same; row += 5) {
+    const int band = 1 + row % 5;
+    kScalarKernels.accumulate_rows(&src[row * stride], stride, band, n,
+                                   &expected[0]);
+    kernels.accumulate_rows(&src[row * stride], stride, band, n, &actual[0]);
+    same = memcmp(&expected[0], &actual[0], n * sizeof(uint16_t)) == 0;
+  }
+  *report << "accumulate_rows " << CpuLevelName(kernels.level) << ": "
+          << (same ? "identical" : "MISMATCH") << "\n";
+  return same;
+}
+
+static bool VerifyAbsDiff(const Kernels& kernels, std::ostream* report) {
+  const int n = 6912 + 45;
+  std::vector<uint8_t> a(n), b(n), expected(n), actual(n);
+  for (int i = 0; i < n; ++i) {
+    a[i] = static_cast<uint8_t>(rand());
+    b[i] = static_cast<uint8_t>(rand());
+  }
+  uint64_t expected_sad = 0, expected_ssd = 0, sad = 0, ssd = 0;
+  kScalarKernels.abs_diff(&a[0], &b[0], n, &expected[0], &expected_sad,
+                          &expected_ssd);
+  kernels.abs_diff(&a[0], &b[0], n, &actual[0], &sad, &ssd);
+  const bool same = memcmp(&expected[0], &actual[0], n) == 0 &&
+                    sad == expected_sad && ssd == expected_ssd;
+  *report << "abs_diff " << CpuLevelName(kernels.level) << ": "
+          << (same ? "identical" : "MISMATCH") << "\n";
+  return same;
+}
+
+bool VerifyKernels(std::string* report) {
+  std::ostringstream ss;
+  bool ok = true;
+  for (int level = kCpuScalar; level < kNumCpuLevels; ++level) {
+    const Kernels* kernels = KernelsForLevel(static_cast<CpuLevel>(level));
+    if (kernels == NULL) {
+      ss << CpuLevelName(static_cast<CpuLevel>(level)) << ": unavailable\n";
+      continue;
+    }
+    ok = VerifyHwcToPlanar(*kernels, &ss) && ok;
+    ok = VerifyIouRow(*kernels, &ss) && ok;
+    ok = VerifyAccumulateRows(*kernels, &ss) && ok;
+    ok = VerifyAbsDiff(*kernels, &ss) && ok;
+  }
+  *report += ss.str();
+  return ok;
+}
+
+}  // namespace textile
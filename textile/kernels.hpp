@@ -0,0 +1,80 @@
+// Kernels with per-ISA variants, bound at runtime to the best level the CPU
+// supports (see cpu_features.hpp).
+//
+// Each variant lives in its own translation unit (kernels_<isa>.cpp) that
+// is the only one compiled with that ISA enabled, so nothing outside it can
+// pick up instructions the CPU may lack. Every variant must produce the same
+// output as the scalar one; VerifyKernels() checks that.
+//
+#ifndef TEXTILE_KERNELS_HPP_
+#define TEXTILE_KERNELS_HPP_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "textile/cpu_features.hpp"
+
+namespace textile {
+
+/* Interleaved 8-bit image (gray or BGR) to planar float with a per-channel
+ * mean subtracted: dst[c * height * width + y * width + x] =
+ * src[y * src_stride + x * channels + c] - mean[c]. This is the cvtColor-free
+ * part of Detector::Preprocess fused into a single pass over the pixels. */
+typedef void (*HwcToPlanarFn)(const uint8_t* src, int width, int height,
+                              int src_stride, int channels,
+                              const float* mean, float* dst);
+
+/* IoU of the box (xmin, ymin, xmax, ymax) of the given area with each of n
+ * boxes stored as separate coordinate and area arrays (see box_set.hpp):
+ * iou[j] = intersection / union, 0 where the union is empty. */
+typedef void (*IouRowFn)(float xmin, float ymin, float xmax, float ymax,
+                         float area, const float* xmins, const float* ymins,
+                         const float* xmaxs, const float* ymaxs,
+                         const float* areas, int n, float* iou);
+
+/* acc[i] += src[r * src_stride + i] for r < rows, i < n: image rows added
+ * to the column sums of a band (see frame_grid.hpp). The caller keeps the
+ * sums from wrapping. */
+typedef void (*AccumulateRowsFn)(const uint8_t* src, int src_stride,
+                                 int rows, int n, uint16_t* acc);
+
+/* diff[i] = |a[i] - b[i]| for n values; adds the sum of the differences to
+ * *sad and of their squares to *ssd. */
+typedef void (*AbsDiffFn)(const uint8_t* a, const uint8_t* b, int n,
+                          uint8_t* diff, uint64_t* sad, uint64_t* ssd);
+
+struct Kernels {
+  CpuLevel level;
+  HwcToPlanarFn hwc_to_planar;
+  IouRowFn iou_row;
+  AccumulateRowsFn accumulate_rows;
+  AbsDiffFn abs_diff;
+};
+
+/* Kernels bound to ActiveCpuLevel(). */
+const Kernels& GetKernels();
+
+/* Kernels of one variant, or NULL if it was not compiled in or the CPU
+ * lacks it. */
+const Kernels* KernelsForLevel(CpuLevel level);
+
+/* Run every available variant on the same random inputs and compare with
+ * the scalar one. Appends one line per kernel and variant to report. */
+bool VerifyKernels(std::string* report);
+
+/* Variant tables, defined in their own translation units. */
+extern const Kernels kScalarKernels;
+#ifdef TEXTILE_HAVE_SSE42
+extern const Kernels kSSE42Kernels;
+#endif
+#ifdef TEXTILE_HAVE_AVX2
+extern const Kernels kAVX2Kernels;
+#endif
+#ifdef TEXTILE_HAVE_AVX512
+extern const Kernels kAVX512Kernels;
+#endif
+
+}  // namespace textile
+
+#endif  // TEXTILE_KERNELS_HPP_
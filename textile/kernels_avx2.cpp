@@ -0,0 +1,157 @@
+// AVX2 kernels. Compiled with -mavx2 -mfma only; see kernels.hpp.
+#include "textile/kernels.hpp"
+#include "textile/kernels_x86.hpp"
+
+namespace textile {
+
+/* 16 u8 values minus mean, stored as 16 floats. */
+static inline void StoreMinusMean16(__m128i v, __m256 mean, float* out) {
+  const __m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v));
+  const __m256 hi =
+      _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(v, 8)));
+  _mm256_storeu_ps(out, _mm256_sub_ps(lo, mean));
+  _mm256_storeu_ps(out + 8, _mm256_sub_ps(hi, mean));
+}
+
+static void HwcToPlanarAVX2(const uint8_t* src, int width, int height,
+                            int src_stride, int channels,
+                            const float* mean, float* dst) {
+  const int plane = width * height;
+  const __m256 mean0 = _mm256_set1_ps(mean[0]);
+  const __m256 mean1 = _mm256_set1_ps(channels == 3 ? mean[1] : 0.f);
+  const __m256 mean2 = _mm256_set1_ps(channels == 3 ? mean[2] : 0.f);
+  for (int y = 0; y < height; ++y) {
+    const uint8_t* row = src + y * src_stride;
+    float* out = dst + y * width;
+    int x = 0;
+    if (channels == 3) {
+      for (; x + 16 <= width; x += 16) {
+        __m128i b, g, r;
+        DeinterleaveBGR16(row + 3 * x, &b, &g, &r);
+        StoreMinusMean16(b, mean0, out + x);
+        StoreMinusMean16(g, mean1, out + plane + x);
+        StoreMinusMean16(r, mean2, out + 2 * plane + x);
+      }
+    } else if (channels == 1) {
+      for (; x + 16 <= width; x += 16) {
+        StoreMinusMean16(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x)),
+            mean0, out + x);
+      }
+    }
+    HwcToPlanarTail(row, x, width, channels, plane, mean, out);
+  }
+}
+
+static void IouRowAVX2(float xmin, float ymin, float xmax, float ymax,
+                       float area, const float* xmins, const float* ymins,
+                       const float* xmaxs, const float* ymaxs,
+                       const float* areas, int n, float* iou) {
+  const __m256 x0 = _mm256_set1_ps(xmin);
+  const __m256 y0 = _mm256_set1_ps(ymin);
+  const __m256 x1 = _mm256_set1_ps(xmax);
+  const __m256 y1 = _mm256_set1_ps(ymax);
+  const __m256 a = _mm256_set1_ps(area);
+  const __m256 zero = _mm256_setzero_ps();
+  int j = 0;
+  for (; j + 8 <= n; j += 8) {
+    const __m256 w = _mm256_max_ps(_mm256_sub_ps(
+        _mm256_min_ps(_mm256_loadu_ps(xmaxs + j), x1),
+        _mm256_max_ps(_mm256_loadu_ps(xmins + j), x0)), zero);
+    const __m256 h = _mm256_max_ps(_mm256_sub_ps(
+        _mm256_min_ps(_mm256_loadu_ps(ymaxs + j), y1),
+        _mm256_max_ps(_mm256_loadu_ps(ymins + j), y0)), zero);
+    const __m256 inter = _mm256_mul_ps(w, h);
+    const __m256 uni = _mm256_sub_ps(
+        _mm256_add_ps(a, _mm256_loadu_ps(areas + j)), inter);
+    // Lanes with an empty union divide by zero and are masked to 0.
+    const __m256 valid = _mm256_cmp_ps(uni, zero, _CMP_GT_OQ);
+    _mm256_storeu_ps(iou + j,
+                     _mm256_and_ps(valid, _mm256_div_ps(inter, uni)));
+  }
+  IouRowTail(xmin, ymin, xmax, ymax, area, xmins, ymins, xmaxs, ymaxs, areas,
+             j, n, iou);
+}
+
+static void AccumulateRowsAVX2(const uint8_t* src, int src_stride, int rows,
+                               int n, uint16_t* acc) {
+  const __m256i zero = _mm256_setzero_si256();
+  int i = 0;
+  // Column by column through the band, so each sum is loaded and stored
+  // once per call. Unpacking widens within 128-bit lanes: lo holds values
+  // 0-7 and 16-23 of the 32, hi 8-15 and 24-31, until they are stored.
+  for (; i + 32 <= n; i += 32) {
+    __m256i* acc0 = reinterpret_cast<__m256i*>(acc + i);
+    __m256i* acc1 = reinterpret_cast<__m256i*>(acc + i + 16);
+    const __m256i a = _mm256_loadu_si256(acc0);
+    const __m256i b = _mm256_loadu_si256(acc1);
+    __m256i lo = _mm256_permute2x128_si256(a, b, 0x20);
+    __m256i hi = _mm256_permute2x128_si256(a, b, 0x31);
+    const uint8_t* p = src + i;
+    int r = 0;
+    for (; r + 2 <= rows; r += 2, p += 2 * src_stride) {
+      const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+      const __m256i w = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(p + src_stride));
+      lo = _mm256_add_epi16(lo, _mm256_add_epi16(
+          _mm256_unpacklo_epi8(v, zero), _mm256_unpacklo_epi8(w, zero)));
+      hi = _mm256_add_epi16(hi, _mm256_add_epi16(
+          _mm256_unpackhi_epi8(v, zero), _mm256_unpackhi_epi8(w, zero)));
+    }
+    if (r < rows) {
+      const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+      lo = _mm256_add_epi16(lo, _mm256_unpacklo_epi8(v, zero));
+      hi = _mm256_add_epi16(hi, _mm256_unpackhi_epi8(v, zero));
+    }
+    _mm256_storeu_si256(acc0, _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256(acc1, _mm256_permute2x128_si256(lo, hi, 0x31));
+  }
+  AccumulateRowsTail(src, src_stride, rows, i, n, acc);
+}
+
+static void AbsDiffAVX2(const uint8_t* a, const uint8_t* b, int n,
+                        uint8_t* diff, uint64_t* sad, uint64_t* ssd) {
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i sad64 = zero;
+  __m256i ssd64 = zero;
+  int i = 0;
+  while (i + 32 <= n) {
+    // Each 32-bit lane gains at most 4 * 255^2 per step: widen to 64 bits
+    // long before it can wrap.
+    __m256i ssd32 = zero;
+    const int block_end = std::min(n, i + 32 * 4096);
+    for (; i + 32 <= block_end; i += 32) {
+      const __m256i va =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+      const __m256i vb =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+      const __m256i d = _mm256_or_si256(_mm256_subs_epu8(va, vb),
+                                        _mm256_subs_epu8(vb, va));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(diff + i), d);
+      sad64 = _mm256_add_epi64(sad64, _mm256_sad_epu8(d, zero));
+      const __m256i lo = _mm256_unpacklo_epi8(d, zero);
+      const __m256i hi = _mm256_unpackhi_epi8(d, zero);
+      ssd32 = _mm256_add_epi32(ssd32, _mm256_add_epi32(
+          _mm256_madd_epi16(lo, lo), _mm256_madd_epi16(hi, hi)));
+    }
+    ssd64 = _mm256_add_epi64(ssd64, _mm256_add_epi64(
+        _mm256_unpacklo_epi32(ssd32, zero),
+        _mm256_unpackhi_epi32(ssd32, zero)));
+  }
+  uint64_t lanes[4];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), sad64);
+  *sad += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), ssd64);
+  *ssd += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+  AbsDiffTail(a, b, i, n, diff, sad, ssd);
+}
+
+const Kernels kAVX2Kernels = {
+  kCpuAVX2,
+  HwcToPlanarAVX2,
+  IouRowAVX2,
+  AccumulateRowsAVX2,
+  AbsDiffAVX2,
+};
+
+}  // namespace textile
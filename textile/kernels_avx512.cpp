@@ -0,0 +1,151 @@
+// AVX-512 kernels. Compiled with -mavx512f -mavx512bw only; see kernels.hpp.
+#include "textile/kernels.hpp"
+#include "textile/kernels_x86.hpp"
+
+namespace textile {
+
+/* 16 u8 values minus mean, stored as 16 floats. */
+static inline void StoreMinusMean16(__m128i v, __m512 mean, float* out) {
+  const __m512 f = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(v));
+  _mm512_storeu_ps(out, _mm512_sub_ps(f, mean));
+}
+
+static void HwcToPlanarAVX512(const uint8_t* src, int width, int height,
+                              int src_stride, int channels,
+                              const float* mean, float* dst) {
+  const int plane = width * height;
+  const __m512 mean0 = _mm512_set1_ps(mean[0]);
+  const __m512 mean1 = _mm512_set1_ps(channels == 3 ? mean[1] : 0.f);
+  const __m512 mean2 = _mm512_set1_ps(channels == 3 ? mean[2] : 0.f);
+  for (int y = 0; y < height; ++y) {
+    const uint8_t* row = src + y * src_stride;
+    float* out = dst + y * width;
+    int x = 0;
+    if (channels == 3) {
+      for (; x + 16 <= width; x += 16) {
+        __m128i b, g, r;
+        DeinterleaveBGR16(row + 3 * x, &b, &g, &r);
+        StoreMinusMean16(b, mean0, out + x);
+        StoreMinusMean16(g, mean1, out + plane + x);
+        StoreMinusMean16(r, mean2, out + 2 * plane + x);
+      }
+    } else if (channels == 1) {
+      for (; x + 16 <= width; x += 16) {
+        StoreMinusMean16(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x)),
+            mean0, out + x);
+      }
+    }
+    HwcToPlanarTail(row, x, width, channels, plane, mean, out);
+  }
+}
+
+static void IouRowAVX512(float xmin, float ymin, float xmax, float ymax,
+                         float area, const float* xmins, const float* ymins,
+                         const float* xmaxs, const float* ymaxs,
+                         const float* areas, int n, float* iou) {
+  const __m512 x0 = _mm512_set1_ps(xmin);
+  const __m512 y0 = _mm512_set1_ps(ymin);
+  const __m512 x1 = _mm512_set1_ps(xmax);
+  const __m512 y1 = _mm512_set1_ps(ymax);
+  const __m512 a = _mm512_set1_ps(area);
+  const __m512 zero = _mm512_setzero_ps();
+  int j = 0;
+  for (; j + 16 <= n; j += 16) {
+    const __m512 w = _mm512_max_ps(_mm512_sub_ps(
+        _mm512_min_ps(_mm512_loadu_ps(xmaxs + j), x1),
+        _mm512_max_ps(_mm512_loadu_ps(xmins + j), x0)), zero);
+    const __m512 h = _mm512_max_ps(_mm512_sub_ps(
+        _mm512_min_ps(_mm512_loadu_ps(ymaxs + j), y1),
+        _mm512_max_ps(_mm512_loadu_ps(ymins + j), y0)), zero);
+    const __m512 inter = _mm512_mul_ps(w, h);
+    const __m512 uni = _mm512_sub_ps(
+        _mm512_add_ps(a, _mm512_loadu_ps(areas + j)), inter);
+    // Lanes with an empty union are not divided and stay 0.
+    const __mmask16 valid = _mm512_cmp_ps_mask(uni, zero, _CMP_GT_OQ);
+    _mm512_storeu_ps(iou + j, _mm512_maskz_div_ps(valid, inter, uni));
+  }
+  IouRowTail(xmin, ymin, xmax, ymax, area, xmins, ymins, xmaxs, ymaxs, areas,
+             j, n, iou);
+}
+
+static void AccumulateRowsAVX512(const uint8_t* src, int src_stride,
+                                 int rows, int n, uint16_t* acc) {
+  const __m512i zero = _mm512_setzero_si512();
+  // Unpacking widens within 128-bit lanes: lo holds the values 0-7, 16-23,
+  // 32-39 and 48-55 of the 64, hi the others, until they are stored.
+  const __m512i to_lo = _mm512_setr_epi64(0, 1, 4, 5, 8, 9, 12, 13);
+  const __m512i to_hi = _mm512_setr_epi64(2, 3, 6, 7, 10, 11, 14, 15);
+  const __m512i from_lo = _mm512_setr_epi64(0, 1, 8, 9, 2, 3, 10, 11);
+  const __m512i from_hi = _mm512_setr_epi64(4, 5, 12, 13, 6, 7, 14, 15);
+  int i = 0;
+  // Column by column through the band, so each sum is loaded and stored
+  // once per call.
+  for (; i + 64 <= n; i += 64) {
+    const __m512i a = _mm512_loadu_si512(acc + i);
+    const __m512i b = _mm512_loadu_si512(acc + i + 32);
+    __m512i lo = _mm512_permutex2var_epi64(a, to_lo, b);
+    __m512i hi = _mm512_permutex2var_epi64(a, to_hi, b);
+    const uint8_t* p = src + i;
+    int r = 0;
+    for (; r + 2 <= rows; r += 2, p += 2 * src_stride) {
+      const __m512i v = _mm512_loadu_si512(p);
+      const __m512i w = _mm512_loadu_si512(p + src_stride);
+      lo = _mm512_add_epi16(lo, _mm512_add_epi16(
+          _mm512_unpacklo_epi8(v, zero), _mm512_unpacklo_epi8(w, zero)));
+      hi = _mm512_add_epi16(hi, _mm512_add_epi16(
+          _mm512_unpackhi_epi8(v, zero), _mm512_unpackhi_epi8(w, zero)));
+    }
+    if (r < rows) {
+      const __m512i v = _mm512_loadu_si512(p);
+      lo = _mm512_add_epi16(lo, _mm512_unpacklo_epi8(v, zero));
+      hi = _mm512_add_epi16(hi, _mm512_unpackhi_epi8(v, zero));
+    }
+    _mm512_storeu_si512(acc + i, _mm512_permutex2var_epi64(lo, from_lo, hi));
+    _mm512_storeu_si512(acc + i + 32,
+                        _mm512_permutex2var_epi64(lo, from_hi, hi));
+  }
+  AccumulateRowsTail(src, src_stride, rows, i, n, acc);
+}
+
+static void AbsDiffAVX512(const uint8_t* a, const uint8_t* b, int n,
+                          uint8_t* diff, uint64_t* sad, uint64_t* ssd) {
+  const __m512i zero = _mm512_setzero_si512();
+  __m512i sad64 = zero;
+  __m512i ssd64 = zero;
+  int i = 0;
+  while (i + 64 <= n) {
+    // Each 32-bit lane gains at most 4 * 255^2 per step: widen to 64 bits
+    // long before it can wrap.
+    __m512i ssd32 = zero;
+    const int block_end = std::min(n, i + 64 * 4096);
+    for (; i + 64 <= block_end; i += 64) {
+      const __m512i va = _mm512_loadu_si512(a + i);
+      const __m512i vb = _mm512_loadu_si512(b + i);
+      const __m512i d = _mm512_or_si512(_mm512_subs_epu8(va, vb),
+                                        _mm512_subs_epu8(vb, va));
+      _mm512_storeu_si512(diff + i, d);
+      sad64 = _mm512_add_epi64(sad64, _mm512_sad_epu8(d, zero));
+      const __m512i lo = _mm512_unpacklo_epi8(d, zero);
+      const __m512i hi = _mm512_unpackhi_epi8(d, zero);
+      ssd32 = _mm512_add_epi32(ssd32, _mm512_add_epi32(
+          _mm512_madd_epi16(lo, lo), _mm512_madd_epi16(hi, hi)));
+    }
+    ssd64 = _mm512_add_epi64(ssd64, _mm512_add_epi64(
+        _mm512_unpacklo_epi32(ssd32, zero),
+        _mm512_unpackhi_epi32(ssd32, zero)));
+  }
+  *sad += _mm512_reduce_add_epi64(sad64);
+  *ssd += _mm512_reduce_add_epi64(ssd64);
+  AbsDiffTail(a, b, i, n, diff, sad, ssd);
+}
+
+const Kernels kAVX512Kernels = {
+  kCpuAVX512,
+  HwcToPlanarAVX512,
+  IouRowAVX512,
+  AccumulateRowsAVX512,
+  AbsDiffAVX512,
+};
+
+}  // namespace textile
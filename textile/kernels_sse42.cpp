@@ -0,0 +1,152 @@
+// SSE4.2 kernels. Compiled with -msse4.2 only; see kernels.hpp.
+#include "textile/kernels.hpp"
+#include "textile/kernels_x86.hpp"
+
+namespace textile {
+
+/* 16 u8 values minus mean, stored as 16 floats. */
+static inline void StoreMinusMean16(__m128i v, __m128 mean, float* out) {
+  for (int i = 0; i < 4; ++i) {
+    const __m128 f = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(v));
+    _mm_storeu_ps(out + 4 * i, _mm_sub_ps(f, mean));
+    v = _mm_srli_si128(v, 4);
+  }
+}
+
+static void HwcToPlanarSSE42(const uint8_t* src, int width, int height,
+                             int src_stride, int channels,
+                             const float* mean, float* dst) {
+  const int plane = width * height;
+  const __m128 mean0 = _mm_set1_ps(mean[0]);
+  const __m128 mean1 = _mm_set1_ps(channels == 3 ? mean[1] : 0.f);
+  const __m128 mean2 = _mm_set1_ps(channels == 3 ? mean[2] : 0.f);
+  for (int y = 0; y < height; ++y) {
+    const uint8_t* row = src + y * src_stride;
+    float* out = dst + y * width;
+    int x = 0;
+    if (channels == 3) {
+      for (; x + 16 <= width; x += 16) {
+        __m128i b, g, r;
+        DeinterleaveBGR16(row + 3 * x, &b, &g, &r);
+        StoreMinusMean16(b, mean0, out + x);
+        StoreMinusMean16(g, mean1, out + plane + x);
+        StoreMinusMean16(r, mean2, out + 2 * plane + x);
+      }
+    } else if (channels == 1) {
+      for (; x + 16 <= width; x += 16) {
+        StoreMinusMean16(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x)),
+            mean0, out + x);
+      }
+    }
+    HwcToPlanarTail(row, x, width, channels, plane, mean, out);
+  }
+}
+
+static void IouRowSSE42(float xmin, float ymin, float xmax, float ymax,
+                        float area, const float* xmins, const float* ymins,
+                        const float* xmaxs, const float* ymaxs,
+                        const float* areas, int n, float* iou) {
+  const __m128 x0 = _mm_set1_ps(xmin);
+  const __m128 y0 = _mm_set1_ps(ymin);
+  const __m128 x1 = _mm_set1_ps(xmax);
+  const __m128 y1 = _mm_set1_ps(ymax);
+  const __m128 a = _mm_set1_ps(area);
+  const __m128 zero = _mm_setzero_ps();
+  int j = 0;
+  for (; j + 4 <= n; j += 4) {
+    const __m128 w = _mm_max_ps(_mm_sub_ps(
+        _mm_min_ps(_mm_loadu_ps(xmaxs + j), x1),
+        _mm_max_ps(_mm_loadu_ps(xmins + j), x0)), zero);
+    const __m128 h = _mm_max_ps(_mm_sub_ps(
+        _mm_min_ps(_mm_loadu_ps(ymaxs + j), y1),
+        _mm_max_ps(_mm_loadu_ps(ymins + j), y0)), zero);
+    const __m128 inter = _mm_mul_ps(w, h);
+    const __m128 uni =
+        _mm_sub_ps(_mm_add_ps(a, _mm_loadu_ps(areas + j)), inter);
+    // Lanes with an empty union divide by zero and are masked to 0.
+    const __m128 valid = _mm_cmpgt_ps(uni, zero);
+    _mm_storeu_ps(iou + j, _mm_and_ps(valid, _mm_div_ps(inter, uni)));
+  }
+  IouRowTail(xmin, ymin, xmax, ymax, area, xmins, ymins, xmaxs, ymaxs, areas,
+             j, n, iou);
+}
+
+static void AccumulateRowsSSE42(const uint8_t* src, int src_stride, int rows,
+                                int n, uint16_t* acc) {
+  const __m128i zero = _mm_setzero_si128();
+  int i = 0;
+  // Column by column through the band, so each sum is loaded and stored
+  // once per call.
+  for (; i + 16 <= n; i += 16) {
+    __m128i* lo_acc = reinterpret_cast<__m128i*>(acc + i);
+    __m128i* hi_acc = reinterpret_cast<__m128i*>(acc + i + 8);
+    __m128i lo = _mm_loadu_si128(lo_acc);
+    __m128i hi = _mm_loadu_si128(hi_acc);
+    const uint8_t* p = src + i;
+    int r = 0;
+    for (; r + 2 <= rows; r += 2, p += 2 * src_stride) {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      const __m128i w =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + src_stride));
+      lo = _mm_add_epi16(lo, _mm_add_epi16(_mm_unpacklo_epi8(v, zero),
+                                           _mm_unpacklo_epi8(w, zero)));
+      hi = _mm_add_epi16(hi, _mm_add_epi16(_mm_unpackhi_epi8(v, zero),
+                                           _mm_unpackhi_epi8(w, zero)));
+    }
+    if (r < rows) {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(v, zero));
+      hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(v, zero));
+    }
+    _mm_storeu_si128(lo_acc, lo);
+    _mm_storeu_si128(hi_acc, hi);
+  }
+  AccumulateRowsTail(src, src_stride, rows, i, n, acc);
+}
+
+static void AbsDiffSSE42(const uint8_t* a, const uint8_t* b, int n,
+                         uint8_t* diff, uint64_t* sad, uint64_t* ssd) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i sad64 = zero;
+  __m128i ssd64 = zero;
+  int i = 0;
+  while (i + 16 <= n) {
+    // Each 32-bit lane gains at most 4 * 255^2 per step: widen to 64 bits
+    // long before it can wrap.
+    __m128i ssd32 = zero;
+    const int block_end = std::min(n, i + 16 * 4096);
+    for (; i + 16 <= block_end; i += 16) {
+      const __m128i va =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+      const __m128i vb =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+      const __m128i d =
+          _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(diff + i), d);
+      sad64 = _mm_add_epi64(sad64, _mm_sad_epu8(d, zero));
+      const __m128i lo = _mm_unpacklo_epi8(d, zero);
+      const __m128i hi = _mm_unpackhi_epi8(d, zero);
+      ssd32 = _mm_add_epi32(ssd32, _mm_add_epi32(_mm_madd_epi16(lo, lo),
+                                                 _mm_madd_epi16(hi, hi)));
+    }
+    ssd64 = _mm_add_epi64(ssd64, _mm_add_epi64(
+        _mm_unpacklo_epi32(ssd32, zero), _mm_unpackhi_epi32(ssd32, zero)));
+  }
+  uint64_t lanes[2];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), sad64);
+  *sad += lanes[0] + lanes[1];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), ssd64);
+  *ssd += lanes[0] + lanes[1];
+  AbsDiffTail(a, b, i, n, diff, sad, ssd);
+}
+
+const Kernels kSSE42Kernels = {
+  kCpuSSE42,
+  HwcToPlanarSSE42,
+  IouRowSSE42,
+  AccumulateRowsSSE42,
+  AbsDiffSSE42,
+};
+
+}  // namespace textile
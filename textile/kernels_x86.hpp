@@ -0,0 +1,108 @@
+// Helpers shared by the x86 kernel variants. Only include this from a
+// kernels_<isa>.cpp: everything here is static so that each variant gets its
+// own copy compiled for its own ISA.
+//
+#ifndef TEXTILE_KERNELS_X86_HPP_
+#define TEXTILE_KERNELS_X86_HPP_
+
+#include <immintrin.h>
+#include <stdint.h>
+
+#include <algorithm>
+
+namespace textile {
+namespace {
+
+/* Split 16 interleaved BGR pixels (48 bytes at src) into three registers
+ * holding the 16 B, G and R values. */
+static inline void DeinterleaveBGR16(const uint8_t* src, __m128i* b,
+                                     __m128i* g, __m128i* r) {
+  const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+  const __m128i m =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+  const __m128i z =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+
+  *b = _mm_or_si128(_mm_or_si128(
+      _mm_shuffle_epi8(a, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1,
+                                        -1, -1, -1, -1, -1, -1)),
+      _mm_shuffle_epi8(m, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11,
+                                        14, -1, -1, -1, -1, -1))),
+      _mm_shuffle_epi8(z, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                        -1, -1, 1, 4, 7, 10, 13)));
+  *g = _mm_or_si128(_mm_or_si128(
+      _mm_shuffle_epi8(a, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1,
+                                        -1, -1, -1, -1, -1, -1)),
+      _mm_shuffle_epi8(m, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12,
+                                        15, -1, -1, -1, -1, -1))),
+      _mm_shuffle_epi8(z, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                        -1, -1, 2, 5, 8, 11, 14)));
+  *r = _mm_or_si128(_mm_or_si128(
+      _mm_shuffle_epi8(a, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1,
+                                        -1, -1, -1, -1, -1, -1)),
+      _mm_shuffle_epi8(m, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13,
+                                        -1, -1, -1, -1, -1, -1))),
+      _mm_shuffle_epi8(z, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                        -1, 0, 3, 6, 9, 12, 15)));
+}
+
+/* Scalar tail of HwcToPlanar for pixels [x, width) of one row. */
+static inline void HwcToPlanarTail(const uint8_t* row, int x, int width,
+                                   int channels, int plane,
+                                   const float* mean, float* out) {
+  for (; x < width; ++x) {
+    for (int c = 0; c < channels; ++c) {
+      out[c * plane + x] = row[x * channels + c] - mean[c];
+    }
+  }
+}
+
+/* Scalar tail of IouRow for boxes [j, n); the same arithmetic as the
+ * scalar variant. */
+static inline void IouRowTail(float xmin, float ymin, float xmax, float ymax,
+                              float area, const float* xmins,
+                              const float* ymins, const float* xmaxs,
+                              const float* ymaxs, const float* areas, int j,
+                              int n, float* iou) {
+  for (; j < n; ++j) {
+    float w = (xmaxs[j] < xmax ? xmaxs[j] : xmax) -
+              (xmins[j] > xmin ? xmins[j] : xmin);
+    float h = (ymaxs[j] < ymax ? ymaxs[j] : ymax) -
+              (ymins[j] > ymin ? ymins[j] : ymin);
+    w = w > 0.f ? w : 0.f;
+    h = h > 0.f ? h : 0.f;
+    const float inter = w * h;
+    const float sum = area + areas[j];
+    const float uni = sum - inter;
+    iou[j] = uni > 0.f ? inter / uni : 0.f;
+  }
+}
+
+/* Scalar tail of AccumulateRows for values [i, n). */
+static inline void AccumulateRowsTail(const uint8_t* src, int src_stride,
+                                      int rows, int i, int n,
+                                      uint16_t* acc) {
+  for (int r = 0; r < rows; ++r) {
+    const uint8_t* row = src + static_cast<int64_t>(r) * src_stride;
+    for (int j = i; j < n; ++j) {
+      acc[j] = static_cast<uint16_t>(acc[j] + row[j]);
+    }
+  }
+}
+
+/* Scalar tail of AbsDiff for values [i, n). */
+static inline void AbsDiffTail(const uint8_t* a, const uint8_t* b, int i,
+                               int n, uint8_t* diff, uint64_t* sad,
+                               uint64_t* ssd) {
+  for (; i < n; ++i) {
+    const int d = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+    diff[i] = static_cast<uint8_t>(d);
+    *sad += d;
+    *ssd += d * d;
+  }
+}
+
+}  // namespace
+}  // namespace textile
+
+#endif  // TEXTILE_KERNELS_X86_HPP_
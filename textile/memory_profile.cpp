@@ -0,0 +1,77 @@
+#include "textile/memory_profile.hpp"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+#include "textile/allocator.hpp"
+
+namespace textile {
+
+const char* MemoryComponentName(MemoryComponent c) {
+  static const char* const kNames[kNumMemoryComponents] = {
+    "weights", "activations", "diffs", "frame_pools", "decoder_buffers",
+    "queues", "output_buffers"
+  };
+  return kNames[c];
+}
+
+MemoryTracker& MemoryTracker::Get() {
+  static MemoryTracker instance;
+  return instance;
+}
+
+std::string MemoryReport::ToString() const {
+  std::ostringstream ss;
+  ss << "Memory footprint (MiB):";
+  for (int i = 0; i < kNumMemoryComponents; ++i) {
+    ss << "\n  " << MemoryComponentName(static_cast<MemoryComponent>(i))
+       << ": " << bytes[i] / 1048576.;
+  }
+  ss << "\n  tracked total: " << Tracked() / 1048576.
+     << "\n  heap in use: " << heap_in_use / 1048576.
+     << "\n  heap mapped: " << heap_mapped / 1048576.
+     << "\n  rss: " << rss / 1048576.;
+  return ss.str();
+}
+
+void MemoryReport::Export(Metrics* metrics) const {
+  for (int i = 0; i < kNumMemoryComponents; ++i) {
+    metrics->Set(std::string("textile_memory_bytes{component=\"") +
+        MemoryComponentName(static_cast<MemoryComponent>(i)) + "\"}",
+        bytes[i]);
+  }
+  metrics->Set("textile_memory_heap_in_use_bytes", heap_in_use);
+  metrics->Set("textile_memory_heap_mapped_bytes", heap_mapped);
+  metrics->Set("textile_memory_rss_bytes", rss);
+}
+
+void AccountProcess(MemoryReport* report) {
+  const AllocatorStats stats = GetAllocatorStats();
+  report->heap_in_use = stats.allocated;
+  report->heap_mapped = stats.mapped;
+
+  long pages = 0, resident = 0;
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (statm != NULL) {
+    if (fscanf(statm, "%ld %ld", &pages, &resident) != 2) {
+      resident = 0;
+    }
+    fclose(statm);
+  }
+  report->rss = static_cast<int64_t>(resident) * sysconf(_SC_PAGESIZE);
+}
+
+MemoryReport CollectMemoryReport() {
+  MemoryReport report;
+  for (int i = kMemFramePools; i < kNumMemoryComponents; ++i) {
+    report.bytes[i] =
+        MemoryTracker::Get().Bytes(static_cast<MemoryComponent>(i));
+  }
+  AccountProcess(&report);
+  return report;
+}
+
+}  // namespace textile
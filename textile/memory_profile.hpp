@@ -0,0 +1,148 @@
+// Per-component memory accounting.
+//
+// The network side (weights, activations, diffs) is read straight off the
+// Caffe blob list, counting only SyncedMemory that has actually been
+// allocated. Everything that lives outside the net (frame buffers, decoder
+// buffers, queues, output buffers) is reported by its owner through a
+// MemoryGauge, so the report is built from what the code holds rather than
+// guessed from RSS. Heap and RSS totals are included so the untracked
+// remainder is visible too.
+//
+#ifndef TEXTILE_MEMORY_PROFILE_HPP_
+#define TEXTILE_MEMORY_PROFILE_HPP_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <caffe/caffe.hpp>
+
+#include "textile/metrics.hpp"
+
+namespace textile {
+
+enum MemoryComponent {
+  kMemWeights = 0,
+  kMemActivations,
+  kMemDiffs,
+  kMemFramePools,
+  kMemDecoderBuffers,
+  kMemQueues,
+  kMemOutputBuffers,
+  kNumMemoryComponents
+};
+
+const char* MemoryComponentName(MemoryComponent c);
+
+/* Process-wide byte counters for the components that are not part of the
+ * Caffe net. Updated by MemoryGauge; read by CollectMemoryReport. */
+class MemoryTracker {
+ public:
+  static MemoryTracker& Get();
+
+  void Add(MemoryComponent c, int64_t delta) {
+    bytes_[c].fetch_add(delta, std::memory_order_relaxed);
+  }
+
+  int64_t Bytes(MemoryComponent c) const {
+    return bytes_[c].load(std::memory_order_relaxed);
+  }
+
+ private:
+  MemoryTracker() {
+    for (int i = 0; i < kNumMemoryComponents; ++i) {
+      bytes_[i].store(0);
+    }
+  }
+  MemoryTracker(const MemoryTracker&);
+  MemoryTracker& operator=(const MemoryTracker&);
+
+  std::atomic<int64_t> bytes_[kNumMemoryComponents];
+};
+
+/* Owner-side handle: call Update() with the number of bytes currently held
+ * and the tracker is adjusted by the difference. Releases on destruction. */
+class MemoryGauge {
+ public:
+  explicit MemoryGauge(MemoryComponent component)
+      : component_(component), bytes_(0) {}
+  ~MemoryGauge() { Update(0); }
+
+  void Update(int64_t bytes) {
+    if (bytes != bytes_) {
+      MemoryTracker::Get().Add(component_, bytes - bytes_);
+      bytes_ = bytes;
+    }
+  }
+
+ private:
+  MemoryGauge(const MemoryGauge&);
+  MemoryGauge& operator=(const MemoryGauge&);
+
+  MemoryComponent component_;
+  int64_t bytes_;
+};
+
+struct MemoryReport {
+  MemoryReport() : heap_in_use(0), heap_mapped(0), rss(0) {
+    for (int i = 0; i < kNumMemoryComponents; ++i) {
+      bytes[i] = 0;
+    }
+  }
+
+  int64_t Tracked() const {
+    int64_t total = 0;
+    for (int i = 0; i < kNumMemoryComponents; ++i) {
+      total += bytes[i];
+    }
+    return total;
+  }
+
+  std::string ToString() const;
+
+  void Export(Metrics* metrics) const;
+
+  int64_t bytes[kNumMemoryComponents];
+  int64_t heap_in_use;
+  int64_t heap_mapped;
+  int64_t rss;
+};
+
+/* Bytes actually backing a SyncedMemory; zero until first touched. */
+inline int64_t AllocatedBytes(caffe::SyncedMemory* mem) {
+  if (mem == NULL || mem->head() == caffe::SyncedMemory::UNINITIALIZED) {
+    return 0;
+  }
+  return mem->size();
+}
+
+/* Add the blobs of net to report. Parameter blobs count as weights, every
+ * other blob as activations; diffs are counted wherever they were
+ * allocated (normally nowhere in a TEST net). */
+template <typename Dtype>
+void AccountNet(const caffe::Net<Dtype>& net, MemoryReport* report) {
+  const std::vector<boost::shared_ptr<caffe::Blob<Dtype> > >& params =
+      net.params();
+  for (size_t i = 0; i < params.size(); ++i) {
+    report->bytes[kMemWeights] += AllocatedBytes(params[i]->data().get());
+    report->bytes[kMemDiffs] += AllocatedBytes(params[i]->diff().get());
+  }
+  const std::vector<boost::shared_ptr<caffe::Blob<Dtype> > >& blobs =
+      net.blobs();
+  for (size_t i = 0; i < blobs.size(); ++i) {
+    report->bytes[kMemActivations] += AllocatedBytes(blobs[i]->data().get());
+    report->bytes[kMemDiffs] += AllocatedBytes(blobs[i]->diff().get());
+  }
+}
+
+/* Heap totals as seen by the allocator, and RSS from /proc. */
+void AccountProcess(MemoryReport* report);
+
+/* Tracker components plus process totals; the caller adds the nets. */
+MemoryReport CollectMemoryReport();
+
+}  // namespace textile
+
+#endif  // TEXTILE_MEMORY_PROFILE_HPP_
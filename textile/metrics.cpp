@@ -0,0 +1,58 @@
+#include "textile/metrics.hpp"
+
+#include <stdio.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace textile {
+
+Metrics& Metrics::Get() {
+  static Metrics instance;
+  return instance;
+}
+
+void Metrics::Set(const std::string& name, double value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  values_[name] = value;
+}
+
+void Metrics::Add(const std::string& name, double delta) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  values_[name] += delta;
+}
+
+double Metrics::Value(const std::string& name) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::map<std::string, double>::const_iterator it = values_.find(name);
+  return it == values_.end() ? 0. : it->second;
+}
+
+std::string Metrics::ToString() const {
+  std::ostringstream ss;
+  ss.precision(15);
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (std::map<std::string, double>::const_iterator it = values_.begin();
+       it != values_.end(); ++it) {
+    ss << it->first << " " << it->second << "\n";
+  }
+  return ss.str();
+}
+
+bool Metrics::WriteTextFile(const std::string& path) const {
+  const std::string tmp_path = path + ".tmp";
+  {
+    std::ofstream out(tmp_path.c_str());
+    if (!out.good()) {
+      return false;
+    }
+    out << ToString();
+    if (!out.good()) {
+      return false;
+    }
+  }
+  return rename(tmp_path.c_str(), path.c_str()) == 0;
+}
+
+}  // namespace textile
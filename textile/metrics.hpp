@@ -0,0 +1,43 @@
+// A minimal process-wide metrics registry.
+//
+// Values are plain doubles keyed by their full Prometheus series name, e.g.
+//    textile_memory_bytes{component="weights"}
+// and the registry can be dumped in the Prometheus text exposition format to
+// a file, which node_exporter's textfile collector (or a human with `cat`)
+// picks up. This is the live surface for everything the detector reports.
+//
+#ifndef TEXTILE_METRICS_HPP_
+#define TEXTILE_METRICS_HPP_
+
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace textile {
+
+class Metrics {
+ public:
+  static Metrics& Get();
+
+  void Set(const std::string& name, double value);
+  void Add(const std::string& name, double delta);
+  double Value(const std::string& name) const;
+
+  std::string ToString() const;
+
+  /* Write all series to path. The file is written next to the target and
+   * renamed into place so that readers never see a partial dump. */
+  bool WriteTextFile(const std::string& path) const;
+
+ private:
+  Metrics() {}
+  Metrics(const Metrics&);
+  Metrics& operator=(const Metrics&);
+
+  mutable std::mutex mutex_;
+  std::map<std::string, double> values_;
+};
+
+}  // namespace textile
+
+#endif  // TEXTILE_METRICS_HPP_
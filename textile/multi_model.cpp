@@ -0,0 +1,172 @@
+#include "textile/multi_model.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include "textile/allocator.hpp"
+
+namespace textile {
+
+MultiModelRunner::MultiModelRunner()
+    : started_(false), imgs_(NULL), num_(0), threshold_(0.f),
+      generation_(0), pending_(0), stop_(false) {}
+
+MultiModelRunner::~MultiModelRunner() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  work_cv_.notify_all();
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    workers_[i].join();
+  }
+}
+
+int MultiModelRunner::AddModel(const std::string& name, Detector* detector,
+                               float threshold) {
+  CHECK(!started_) << "Models must be added before the first Detect.";
+  std::unique_ptr<Model> model(new Model());
+  model->name = name;
+  model->detector.reset(detector);
+  model->threshold = threshold;
+  model->group = -1;
+  model->capacity = 64;
+  models_.push_back(std::move(model));
+  return num_models() - 1;
+}
+
+void MultiModelRunner::Start() {
+  CHECK(!models_.empty()) << "No model to run.";
+  for (int m = 0; m < num_models(); ++m) {
+    const Detector& detector = *models_[m]->detector;
+    for (int g = 0; g < num_groups(); ++g) {
+      const Detector& leader = *models_[groups_[g].leader]->detector;
+      if (leader.input_geometry() == detector.input_geometry() &&
+          leader.num_channels() == detector.num_channels() &&
+          leader.mean_values() == detector.mean_values()) {
+        models_[m]->group = g;
+        break;
+      }
+    }
+    if (models_[m]->group < 0) {
+      Group group;
+      group.leader = m;
+      group.input = NULL;
+      models_[m]->group = num_groups();
+      groups_.push_back(group);
+    }
+  }
+  LOG(INFO) << num_models() << " model(s) in " << num_groups()
+            << " preprocessing group(s)";
+
+  // A single model runs on the calling thread.
+  if (num_models() > 1) {
+    for (int m = 0; m < num_models(); ++m) {
+      workers_.push_back(std::thread(&MultiModelRunner::WorkerLoop, this, m));
+    }
+  }
+  started_ = true;
+}
+
+void MultiModelRunner::WorkerLoop(int model) {
+  BindThreadArena();
+  BindCaffeMode();
+  int64_t seen = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_cv_.wait(lock, [&] { return stop_ || generation_ != seen; });
+      if (stop_) {
+        return;
+      }
+      seen = generation_;
+    }
+    RunModel(model);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --pending_;
+    }
+    done_cv_.notify_one();
+  }
+}
+
+void MultiModelRunner::RunModel(int m) {
+  Model& model = *models_[m];
+  model.detector->ForwardPrepared(*groups_[model.group].input);
+  const float threshold =
+      model.threshold >= 0.f ? model.threshold : threshold_;
+  model.counts.resize(num_);
+  while (true) {
+    model.detections.resize(num_ * model.capacity);
+    model.detector->Collect(imgs_, num_, threshold, &model.detections[0],
+                            model.capacity, &model.counts[0]);
+    const int most = *std::max_element(model.counts.begin(),
+                                       model.counts.end());
+    if (most <= model.capacity) {
+      break;
+    }
+    // Collect reads the output of the forward pass again; no rerun.
+    model.capacity = most;
+  }
+}
+
+void MultiModelRunner::Detect(const cv::Mat* imgs, int num, float threshold,
+                              std::vector<ModelDetection>* out) {
+  out->clear();
+  if (num <= 0) {
+    return;
+  }
+  if (!started_) {
+    Start();
+  }
+  imgs_ = imgs;
+  num_ = num;
+  threshold_ = threshold;
+
+  // Preprocess once per group, on this thread.
+  for (int g = 0; g < num_groups(); ++g) {
+    groups_[g].input =
+        models_[groups_[g].leader]->detector->PrepareInput(imgs, num);
+#ifndef CPU_ONLY
+    // Move the input to the device before the members read it from their
+    // threads, so that none of them triggers the copy concurrently.
+    groups_[g].input->gpu_data();
+#endif
+  }
+
+  if (workers_.empty()) {
+    RunModel(0);
+  } else {
+    std::unique_lock<std::mutex> lock(mutex_);
+    pending_ = num_models();
+    ++generation_;
+    work_cv_.notify_all();
+    done_cv_.wait(lock, [&] { return pending_ == 0; });
+  }
+
+  for (int i = 0; i < num; ++i) {
+    for (int m = 0; m < num_models(); ++m) {
+      const Model& model = *models_[m];
+      const Detection* detections = &model.detections[i * model.capacity];
+      for (int k = 0; k < model.counts[i]; ++k) {
+        ModelDetection d;
+        d.model = m;
+        d.image = i;
+        d.detection = detections[k];
+        out->push_back(d);
+      }
+    }
+  }
+}
+
+void MultiModelRunner::AccountMemory(MemoryReport* report) const {
+  for (size_t m = 0; m < models_.size(); ++m) {
+    models_[m]->detector->AccountMemory(report);
+    report->bytes[kMemOutputBuffers] +=
+        models_[m]->detections.capacity() * sizeof(Detection);
+  }
+}
+
+}  // namespace textile
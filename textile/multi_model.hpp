@@ -0,0 +1,110 @@
+// Several detectors run on the same frames.
+//
+// Models are grouped by what their preprocessing depends on (input
+// geometry, channel count and mean): the first model of a group prepares
+// its input blob once per call and every other member of the group runs on
+// that blob directly. The nets then run in parallel, one worker thread per
+// model, and their detections are merged into one list tagged with the
+// model that produced them.
+//
+#ifndef TEXTILE_MULTI_MODEL_HPP_
+#define TEXTILE_MULTI_MODEL_HPP_
+
+#include <stdint.h>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "textile/detector.hpp"
+#include "textile/memory_profile.hpp"
+
+namespace textile {
+
+struct ModelDetection {
+  int model;  // index returned by AddModel
+  int image;  // index into the images passed to Detect
+  Detection detection;
+};
+
+/* One label per model and label of the model, for class-aware suppression
+ * with BoxSuppressor. */
+inline int ClassKey(const ModelDetection& d) {
+  return d.model * 65536 + d.detection.label;
+}
+
+class MultiModelRunner {
+ public:
+  MultiModelRunner();
+  ~MultiModelRunner();
+
+  /* Take ownership of detector. A negative threshold means the one passed
+   * to Detect. Returns the index of the model. Models can only be added
+   * before the first call to Detect. */
+  int AddModel(const std::string& name, Detector* detector, float threshold);
+
+  int num_models() const { return static_cast<int>(models_.size()); }
+  int num_groups() const { return static_cast<int>(groups_.size()); }
+  const std::string& model_name(int model) const {
+    return models_[model]->name;
+  }
+  const Detector& detector(int model) const {
+    return *models_[model]->detector;
+  }
+
+  /* Run every model on imgs[0, num) and replace out with their detections,
+   * ordered by image, then by model. Not thread-safe. */
+  void Detect(const cv::Mat* imgs, int num, float threshold,
+              std::vector<ModelDetection>* out);
+
+  void AccountMemory(MemoryReport* report) const;
+
+ private:
+  struct Model {
+    std::string name;
+    std::unique_ptr<Detector> detector;
+    float threshold;
+    int group;
+    /* Per-image result slots and counts, reused from call to call. */
+    std::vector<Detection> detections;
+    std::vector<int> counts;
+    int capacity;
+  };
+
+  struct Group {
+    int leader;  // model that prepares the input
+    const caffe::Blob<float>* input;
+  };
+
+  /* Assign groups and start the workers, on the first Detect. */
+  void Start();
+  void WorkerLoop(int model);
+  /* Forward model on its group's input and collect its detections. */
+  void RunModel(int model);
+
+  std::vector<std::unique_ptr<Model> > models_;
+  std::vector<Group> groups_;
+  bool started_;
+
+  /* The current call, read by the workers. */
+  const cv::Mat* imgs_;
+  int num_;
+  float threshold_;
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  int64_t generation_;
+  int pending_;
+  bool stop_;
+};
+
+}  // namespace textile
+
+#endif  // TEXTILE_MULTI_MODEL_HPP_
@@ -0,0 +1,217 @@
+#include "textile/multi_scale.hpp"
+
+#include <math.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "textile/box_set.hpp"
+
+namespace textile {
+
+/* Boxes closer than this to an inner tile border count as truncated. */
+static const float kBorderPixels = 2.f;
+/* Overlap above which two boxes of different scales are one defect. */
+static const float kMergeIoU = 0.5f;
+
+/* The score ScaleAwareNms ranks a candidate by. */
+static float RankScore(const ScaledDetection& d, float min_size) {
+  const Detection& box = d.detection.detection;
+  float rank = box.score;
+  if (d.truncated) {
+    rank *= 0.5f;
+  }
+  const float size = d.scale * sqrtf(std::max(0.f,
+      (box.xmax - box.xmin) * (box.ymax - box.ymin)));
+  if (size < min_size) {
+    rank *= size / min_size;
+  }
+  return rank;
+}
+
+void ScaleAwareNms(float min_iou, float min_size,
+                   std::vector<ScaledDetection>* detections) {
+  BoxSet boxes;
+  boxes.Reserve(static_cast<int>(detections->size()));
+  for (size_t i = 0; i < detections->size(); ++i) {
+    const ScaledDetection& d = (*detections)[i];
+    const Detection& box = d.detection.detection;
+    boxes.Add(ClassKey(d.detection), RankScore(d, min_size), box.xmin,
+              box.ymin, box.xmax, box.ymax);
+  }
+  // Nms suppresses above its bound, and overlaps of min_iou are to go.
+  BoxSuppressor suppressor;
+  std::vector<int> keep;
+  suppressor.Nms(boxes, nextafterf(min_iou, 0.f), true, &keep);
+
+  std::vector<ScaledDetection> kept(keep.size());
+  for (size_t k = 0; k < keep.size(); ++k) {
+    kept[k] = (*detections)[keep[k]];
+  }
+  detections->swap(kept);
+}
+
+/* Starts of n spans of size tile evenly covering [0, length). */
+static void TileStarts(int length, int tile, float overlap,
+                       std::vector<int>* starts) {
+  starts->clear();
+  if (length <= tile) {
+    starts->push_back(0);
+    return;
+  }
+  const float stride = tile * (1.f - overlap);
+  const int n = static_cast<int>(ceilf((length - tile) / stride)) + 1;
+  for (int i = 0; i < n; ++i) {
+    starts->push_back(static_cast<int>(
+        static_cast<int64_t>(length - tile) * i / (n - 1)));
+  }
+}
+
+void TileGrid(const cv::Size& frame, const cv::Size& tile, float overlap,
+              std::vector<cv::Rect>* tiles) {
+  tiles->clear();
+  if (frame.width <= tile.width && frame.height <= tile.height) {
+    return;
+  }
+  std::vector<int> xs;
+  std::vector<int> ys;
+  TileStarts(frame.width, tile.width, overlap, &xs);
+  TileStarts(frame.height, tile.height, overlap, &ys);
+  for (size_t y = 0; y < ys.size(); ++y) {
+    for (size_t x = 0; x < xs.size(); ++x) {
+      tiles->push_back(cv::Rect(xs[x], ys[y],
+          std::min(tile.width, frame.width),
+          std::min(tile.height, frame.height)));
+    }
+  }
+}
+
+MultiScale::MultiScale(MultiModelRunner* runner, const cv::Size& input,
+                       float overlap, int max_tiles, float seed_threshold,
+                       float min_size)
+    : runner_(runner), input_(input), overlap_(overlap),
+      max_tiles_(max_tiles), seed_threshold_(seed_threshold),
+      min_size_(min_size), scan_(-1) {
+  CHECK_GE(max_tiles, 1);
+  CHECK(overlap >= 0.f && overlap < 1.f) << "overlap must be within [0, 1)";
+}
+
+void MultiScale::Shift(float dx, float dy) {
+  for (size_t s = 0; s < seeds_.size(); ++s) {
+    seeds_[s].xmin += dx;
+    seeds_[s].xmax += dx;
+    seeds_[s].ymin += dy;
+    seeds_[s].ymax += dy;
+  }
+}
+
+void MultiScale::SelectTiles() {
+  selected_.clear();
+  if (grid_.empty()) {
+    return;
+  }
+  for (size_t s = 0; s < seeds_.size(); ++s) {
+    if (static_cast<int>(selected_.size()) >= max_tiles_) {
+      return;
+    }
+    // The tile whose centre is nearest to the seed's.
+    const float cx = 0.5f * (seeds_[s].xmin + seeds_[s].xmax);
+    const float cy = 0.5f * (seeds_[s].ymin + seeds_[s].ymax);
+    int best = 0;
+    float best_distance = -1.f;
+    for (size_t t = 0; t < grid_.size(); ++t) {
+      const float dx = grid_[t].x + 0.5f * grid_[t].width - cx;
+      const float dy = grid_[t].y + 0.5f * grid_[t].height - cy;
+      const float distance = dx * dx + dy * dy;
+      if (best_distance < 0.f || distance < best_distance) {
+        best = static_cast<int>(t);
+        best_distance = distance;
+      }
+    }
+    if (std::find(selected_.begin(), selected_.end(), best) ==
+        selected_.end()) {
+      selected_.push_back(best);
+    }
+  }
+  if (static_cast<int>(selected_.size()) < max_tiles_) {
+    // Scan the tiles no seed asked for.
+    for (size_t i = 0; i < grid_.size(); ++i) {
+      scan_ = (scan_ + 1) % static_cast<int>(grid_.size());
+      if (std::find(selected_.begin(), selected_.end(), scan_) ==
+          selected_.end()) {
+        selected_.push_back(scan_);
+        break;
+      }
+    }
+  }
+}
+
+void MultiScale::Detect(const cv::Mat& img, float threshold,
+                        std::vector<ModelDetection>* out) {
+  if (img.size() != frame_) {
+    frame_ = img.size();
+    TileGrid(frame_, input_, overlap_, &grid_);
+    scan_ = -1;
+    seeds_.clear();
+  }
+  SelectTiles();
+
+  images_.clear();
+  images_.push_back(img);
+  for (size_t t = 0; t < selected_.size(); ++t) {
+    images_.push_back(img(grid_[selected_[t]]));
+  }
+  runner_->Detect(images_.data(), static_cast<int>(images_.size()),
+                  std::min(threshold, seed_threshold_), &raw_);
+
+  const float coarse_scale = sqrtf(
+      static_cast<float>(input_.width) / img.cols *
+      static_cast<float>(input_.height) / img.rows);
+  seeds_.clear();
+  merged_.clear();
+  for (size_t i = 0; i < raw_.size(); ++i) {
+    ScaledDetection d;
+    d.detection = raw_[i];
+    d.scale = coarse_scale;
+    d.truncated = false;
+    Detection& box = d.detection.detection;
+    if (raw_[i].image == 0) {
+      if (box.score >= seed_threshold_) {
+        seeds_.push_back(box);
+      }
+    } else {
+      const cv::Rect& tile = grid_[selected_[raw_[i].image - 1]];
+      d.scale = sqrtf(static_cast<float>(input_.width) / tile.width *
+                      static_cast<float>(input_.height) / tile.height);
+      d.truncated =
+          (tile.x > 0 && box.xmin < kBorderPixels) ||
+          (tile.y > 0 && box.ymin < kBorderPixels) ||
+          (tile.x + tile.width < img.cols &&
+           box.xmax > tile.width - kBorderPixels) ||
+          (tile.y + tile.height < img.rows &&
+           box.ymax > tile.height - kBorderPixels);
+      box.xmin += tile.x;
+      box.xmax += tile.x;
+      box.ymin += tile.y;
+      box.ymax += tile.y;
+      d.detection.image = 0;
+    }
+    if (box.score >= threshold) {
+      merged_.push_back(d);
+    }
+  }
+  std::sort(seeds_.begin(), seeds_.end(),
+      [](const Detection& a, const Detection& b) {
+        return a.score > b.score;
+      });
+
+  ScaleAwareNms(kMergeIoU, min_size_, &merged_);
+  out->clear();
+  for (size_t i = 0; i < merged_.size(); ++i) {
+    out->push_back(merged_[i].detection);
+  }
+}
+
+}  // namespace textile
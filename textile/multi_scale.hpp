@@ -0,0 +1,90 @@
+// Two-scale detection of one stream.
+//
+// The net sees the whole frame scaled down to its input, which is enough
+// for stains but not for a broken yarn. MultiScale adds full-resolution
+// tiles of the net input size to the same batch. The tiles are chosen by
+// the coarse pass of the previous frame: every coarse detection above a
+// low seed threshold gets the tile around it, and one more tile scans the
+// frame round robin so that no part goes unseen for long. The detections
+// of both scales are then merged by ScaleAwareNms.
+//
+#ifndef TEXTILE_MULTI_SCALE_HPP_
+#define TEXTILE_MULTI_SCALE_HPP_
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "textile/multi_model.hpp"
+
+namespace textile {
+
+/* A detection with what is needed to judge it across scales. */
+struct ScaledDetection {
+  ModelDetection detection;
+  /* Net input pixels per frame pixel of the image it was found on. */
+  float scale;
+  /* Cut by a tile border that is not a border of the frame. */
+  bool truncated;
+};
+
+/* Greedy non-maximum suppression across scales, per model and label.
+ * Candidates are ranked by score, discounted for truncated boxes and for
+ * boxes smaller than min_size pixels at the scale they were found at, so
+ * that of two overlapping boxes the one seen at a suitable scale wins.
+ * Keeps the winners in detections, with their original scores. */
+void ScaleAwareNms(float min_iou, float min_size,
+                   std::vector<ScaledDetection>* detections);
+
+/* The tiles of size tile covering frame, overlapping by overlap (a
+ * fraction of tile), in row-major order. None if one tile covers frame. */
+void TileGrid(const cv::Size& frame, const cv::Size& tile, float overlap,
+              std::vector<cv::Rect>* tiles);
+
+class MultiScale {
+ public:
+  /* runner is not owned; input is its net input size. At most max_tiles
+   * tiles run besides the whole frame. */
+  MultiScale(MultiModelRunner* runner, const cv::Size& input, float overlap,
+             int max_tiles, float seed_threshold, float min_size);
+
+  /* Detect on img at both scales in one batch and replace out with the
+   * merged detections in img coordinates. */
+  void Detect(const cv::Mat& img, float threshold,
+              std::vector<ModelDetection>* out);
+
+  /* Move the seeds of the next frame by (dx, dy) pixels: the motion of
+   * the scene since the last Detect. */
+  void Shift(float dx, float dy);
+
+  /* Tiles run by the last Detect. */
+  int num_tiles() const { return static_cast<int>(selected_.size()); }
+
+ private:
+  /* Choose the tiles for img from the seeds of the previous frame. */
+  void SelectTiles();
+
+  MultiModelRunner* runner_;
+  cv::Size input_;
+  float overlap_;
+  int max_tiles_;
+  float seed_threshold_;
+  float min_size_;
+
+  /* The tile grid of frames of size frame_. */
+  cv::Size frame_;
+  std::vector<cv::Rect> grid_;
+  /* The tile scanned last. */
+  int scan_;
+  /* Coarse detections of the previous frame, best first. */
+  std::vector<Detection> seeds_;
+
+  std::vector<int> selected_;
+  std::vector<cv::Mat> images_;
+  std::vector<ModelDetection> raw_;
+  std::vector<ScaledDetection> merged_;
+};
+
+}  // namespace textile
+
+#endif  // TEXTILE_MULTI_SCALE_HPP_
@@ -0,0 +1,64 @@
+#include "textile/result_cache.hpp"
+
+#include <string>
+#include <vector>
+
+#include <glog/logging.h>
+
+namespace textile {
+
+ResultCache::ResultCache(int capacity, int max_distance, int max_reuse)
+    : max_distance_(max_distance), max_reuse_(max_reuse),
+      entries_(capacity), size_(0), next_(0), reused_(0), lookups_(0),
+      hits_(0) {
+  CHECK_GT(capacity, 0);
+}
+
+bool ResultCache::Lookup(const FrameHash& hash) {
+  ++lookups_;
+  if (reused_ >= max_reuse_) {
+    return false;
+  }
+  int best = -1;
+  int best_distance = max_distance_ + 1;
+  for (int i = 0; i < size_; ++i) {
+    const int distance = HashDistance(hash, entries_[i].hash);
+    if (distance < best_distance) {
+      best = i;
+      best_distance = distance;
+    }
+  }
+  if (best < 0 || !entries_[best].clean) {
+    return false;
+  }
+  ++reused_;
+  ++hits_;
+  return true;
+}
+
+void ResultCache::Insert(const FrameHash& hash,
+                         const std::vector<ModelDetection>& detections) {
+  Entry& entry = entries_[next_];
+  entry.hash = hash;
+  entry.clean = detections.empty();
+  next_ = (next_ + 1) % static_cast<int>(entries_.size());
+  if (size_ < static_cast<int>(entries_.size())) {
+    ++size_;
+  }
+  reused_ = 0;
+}
+
+void ResultCache::Export(const std::string& camera, int forwards_per_frame,
+                         Metrics* metrics) const {
+  const std::string label = "{camera=\"" + camera + "\"}";
+  metrics->Set("textile_cache_lookups_total" + label,
+               static_cast<double>(lookups_));
+  metrics->Set("textile_cache_hits_total" + label,
+               static_cast<double>(hits_));
+  metrics->Set("textile_cache_hit_ratio" + label,
+               lookups_ > 0 ? static_cast<double>(hits_) / lookups_ : 0.);
+  metrics->Set("textile_cache_forwards_saved_total" + label,
+               static_cast<double>(hits_) * forwards_per_frame);
+}
+
+}  // namespace textile
@@ -0,0 +1,71 @@
+// Detections of recent frames, keyed by their perceptual hash.
+//
+// On a loom weaving a repeating (e.g. jacquard) pattern the view of a
+// static camera recurs every repeat. ResultCache keeps the hashes of the
+// last frames that went through the nets and whether they had detections;
+// a frame whose hash is closest, within max_distance bits, to a frame that
+// had none is taken to be clean too and skips the forward pass. Frames
+// like one with detections always run the nets: the defects of one repeat
+// are not those of the next, and reusing them would report defects on
+// fabric that has none. So that a new defect on a recurring view is not
+// masked for long, the cache serves at most max_reuse frames in a row
+// before the camera has to run the nets again.
+//
+#ifndef TEXTILE_RESULT_CACHE_HPP_
+#define TEXTILE_RESULT_CACHE_HPP_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "textile/frame_hash.hpp"
+#include "textile/metrics.hpp"
+#include "textile/multi_model.hpp"
+
+namespace textile {
+
+class ResultCache {
+ public:
+  /* Keep the last capacity frames. */
+  ResultCache(int capacity, int max_distance, int max_reuse);
+
+  /* Whether the frame with hash matches a cached frame without
+   * detections, and so has none either. */
+  bool Lookup(const FrameHash& hash);
+
+  /* Cache a frame that went through the nets with its detections,
+   * replacing the oldest entry. */
+  void Insert(const FrameHash& hash,
+              const std::vector<ModelDetection>& detections);
+
+  int64_t lookups() const { return lookups_; }
+  int64_t hits() const { return hits_; }
+
+  /* Set textile_cache_{lookups,hits}_total, textile_cache_hit_ratio and
+   * textile_cache_forwards_saved_total for camera, where a hit saves
+   * forwards_per_frame forward passes. */
+  void Export(const std::string& camera, int forwards_per_frame,
+              Metrics* metrics) const;
+
+ private:
+  struct Entry {
+    FrameHash hash;
+    bool clean;
+  };
+
+  int max_distance_;
+  int max_reuse_;
+  /* Ring of entries; next_ is the oldest once it is full. */
+  std::vector<Entry> entries_;
+  int size_;
+  int next_;
+  /* Frames served from the cache since the last forward pass. */
+  int reused_;
+  int64_t lookups_;
+  int64_t hits_;
+};
+
+}  // namespace textile
+
+#endif  // TEXTILE_RESULT_CACHE_HPP_
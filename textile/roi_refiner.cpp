@@ -0,0 +1,174 @@
+#include "textile/roi_refiner.hpp"
+
+#include <math.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "textile/box_set.hpp"
+
+namespace textile {
+
+/* Grow [*lo, *hi) to at least size, then shift it into [0, limit). */
+static void FitSpan(int size, int limit, int* lo, int* hi) {
+  if (*hi - *lo < size) {
+    const int grow = size - (*hi - *lo);
+    *lo -= grow / 2;
+    *hi += grow - grow / 2;
+  }
+  if (*lo < 0) {
+    *hi -= *lo;
+    *lo = 0;
+  }
+  if (*hi > limit) {
+    *lo -= *hi - limit;
+    *hi = limit;
+  }
+  *lo = std::max(*lo, 0);
+}
+
+cv::Rect RefineWindow(const Detection& box, float padding,
+                      const cv::Size& input, const cv::Size& frame) {
+  const float pad_x = padding * (box.xmax - box.xmin);
+  const float pad_y = padding * (box.ymax - box.ymin);
+  int x0 = static_cast<int>(box.xmin - pad_x);
+  int x1 = static_cast<int>(box.xmax + pad_x + 1.f);
+  int y0 = static_cast<int>(box.ymin - pad_y);
+  int y1 = static_cast<int>(box.ymax + pad_y + 1.f);
+  FitSpan(input.width, frame.width, &x0, &x1);
+  FitSpan(input.height, frame.height, &y0, &y1);
+  return cv::Rect(x0, y0, x1 - x0, y1 - y0);
+}
+
+RoiRefiner::RoiRefiner(MultiModelRunner* runner, const cv::Size& input,
+                       float padding, int max_crops)
+    : runner_(runner), input_(input), padding_(padding),
+      max_crops_(max_crops) {
+  CHECK_GT(max_crops, 0);
+  crops_.reserve(max_crops);
+  images_.reserve(max_crops);
+}
+
+void RoiRefiner::Clear() {
+  crops_.clear();
+  images_.clear();
+}
+
+bool RoiRefiner::AddCrops(int source, const cv::Mat& frame,
+                          const std::vector<Track>& tracks, float threshold) {
+  for (size_t t = 0; t < tracks.size(); ++t) {
+    if (num_crops() >= max_crops_) {
+      return false;
+    }
+    const cv::Rect window =
+        RefineWindow(tracks[t].box, padding_, input_, frame.size());
+    if (window.area() <= 0) {
+      continue;
+    }
+    bool covered = false;
+    for (size_t c = 0; c < crops_.size() && !covered; ++c) {
+      covered = crops_[c].source == source &&
+          (crops_[c].window & window) == window;
+    }
+    if (covered) {
+      continue;
+    }
+    Crop crop;
+    crop.source = source;
+    crop.window = window;
+    crop.threshold = threshold;
+    crops_.push_back(crop);
+    images_.push_back(frame(window));
+  }
+  return num_crops() < max_crops_;
+}
+
+void RoiRefiner::Run(std::vector<ModelDetection>* out) {
+  out->clear();
+  if (crops_.empty()) {
+    return;
+  }
+  float threshold = crops_[0].threshold;
+  for (size_t c = 1; c < crops_.size(); ++c) {
+    threshold = std::min(threshold, crops_[c].threshold);
+  }
+  runner_->Detect(images_.data(), num_crops(), threshold, &detections_);
+  for (size_t i = 0; i < detections_.size(); ++i) {
+    ModelDetection d = detections_[i];
+    const Crop& crop = crops_[d.image];
+    if (d.detection.score < crop.threshold) {
+      continue;
+    }
+    d.image = crop.source;
+    d.detection.xmin += crop.window.x;
+    d.detection.xmax += crop.window.x;
+    d.detection.ymin += crop.window.y;
+    d.detection.ymax += crop.window.y;
+    out->push_back(d);
+  }
+}
+
+/* Add the boxes of detections to boxes, labelled by ClassKey. */
+static void AddBoxes(const std::vector<ModelDetection>& detections,
+                     BoxSet* boxes) {
+  boxes->Clear();
+  boxes->Reserve(static_cast<int>(detections.size()));
+  for (size_t i = 0; i < detections.size(); ++i) {
+    const Detection& d = detections[i].detection;
+    boxes->Add(ClassKey(detections[i]), d.score, d.xmin, d.ymin, d.xmax,
+               d.ymax);
+  }
+}
+
+void MergeRefined(const std::vector<ModelDetection>& refined, int source,
+                  float min_iou, std::vector<ModelDetection>* detections) {
+  std::vector<ModelDetection> candidates;
+  for (size_t i = 0; i < refined.size(); ++i) {
+    if (refined[i].image == source) {
+      candidates.push_back(refined[i]);
+    }
+  }
+  if (candidates.empty()) {
+    return;
+  }
+  BoxSuppressor suppressor;
+  BoxSet boxes;
+  AddBoxes(candidates, &boxes);
+  // Nms suppresses above its bound, and overlaps of min_iou are to go.
+  const float max_iou = nextafterf(min_iou, 0.f);
+  std::vector<int> keep;
+  suppressor.Nms(boxes, max_iou, true, &keep);
+  std::vector<ModelDetection> kept(keep.size());
+  for (size_t k = 0; k < keep.size(); ++k) {
+    kept[k] = candidates[keep[k]];
+  }
+
+  // Drop the full-frame detections a kept one overlaps.
+  BoxSet kept_boxes;
+  AddBoxes(kept, &kept_boxes);
+  AddBoxes(*detections, &boxes);
+  std::vector<float> iou;
+  suppressor.IouMatrix(kept_boxes, boxes, &iou);
+  const int n = boxes.size();
+  size_t num_left = 0;
+  for (int j = 0; j < n; ++j) {
+    bool covered = false;
+    for (int k = 0; k < kept_boxes.size() && !covered; ++k) {
+      covered = kept_boxes.label()[k] == boxes.label()[j] &&
+          iou[static_cast<size_t>(k) * n + j] > max_iou;
+    }
+    if (!covered) {
+      (*detections)[num_left++] = (*detections)[j];
+    }
+  }
+  detections->resize(num_left);
+  for (size_t k = 0; k < kept.size(); ++k) {
+    // Like the full-frame detections, of the one image of the source.
+    kept[k].image = 0;
+    detections->push_back(kept[k]);
+  }
+}
+
+}  // namespace textile
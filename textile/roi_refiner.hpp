@@ -0,0 +1,76 @@
+// Second look at tracked defects at full resolution.
+//
+// The full-frame pass scales the whole frame down to the net input, which
+// loses fine defects. RoiRefiner crops a padded window around every track
+// from the full-resolution frame instead, at least as large as the net
+// input so that the crop is seen at native scale, and runs the crops of
+// all cameras as one batch. The refined boxes are mapped back to frame
+// coordinates and replace the full-frame detections they overlap.
+//
+#ifndef TEXTILE_ROI_REFINER_HPP_
+#define TEXTILE_ROI_REFINER_HPP_
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "textile/multi_model.hpp"
+#include "textile/tracker.hpp"
+
+namespace textile {
+
+/* The window cropped around box: the box grown by padding times its size
+ * on each side, then to at least input, clipped to frame. */
+cv::Rect RefineWindow(const Detection& box, float padding,
+                      const cv::Size& input, const cv::Size& frame);
+
+class RoiRefiner {
+ public:
+  /* runner is not owned. input is the net input size; at most max_crops
+   * crops go into one batch. */
+  RoiRefiner(MultiModelRunner* runner, const cv::Size& input, float padding,
+             int max_crops);
+
+  /* Start a new batch. */
+  void Clear();
+
+  /* Queue crops of frame around tracks, tagged with source. Detections
+   * below threshold are dropped from them. Windows covered by one already
+   * queued for source are skipped. Returns false once the batch is full.
+   * frame must stay valid until Run. */
+  bool AddCrops(int source, const cv::Mat& frame,
+                const std::vector<Track>& tracks, float threshold);
+
+  int num_crops() const { return static_cast<int>(crops_.size()); }
+
+  /* Detect on every queued crop in one batch. out receives the detections
+   * in frame coordinates, with image set to the source. */
+  void Run(std::vector<ModelDetection>* out);
+
+ private:
+  struct Crop {
+    int source;
+    cv::Rect window;
+    float threshold;
+  };
+
+  MultiModelRunner* runner_;
+  cv::Size input_;
+  float padding_;
+  int max_crops_;
+  std::vector<Crop> crops_;
+  std::vector<cv::Mat> images_;
+  std::vector<ModelDetection> detections_;
+};
+
+/* Replace the detections of source in detections (frame coordinates) by
+ * the refined ones: full-frame detections of the same model and label
+ * overlapping a refined one by at least min_iou are dropped, and of
+ * refined detections overlapping each other (neighbouring crops) only the
+ * best scoring one is kept. */
+void MergeRefined(const std::vector<ModelDetection>& refined, int source,
+                  float min_iou, std::vector<ModelDetection>* detections);
+
+}  // namespace textile
+
+#endif  // TEXTILE_ROI_REFINER_HPP_
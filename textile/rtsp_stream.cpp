@@ -0,0 +1,90 @@
+#include "textile/rtsp_stream.hpp"
+
+#include <stdlib.h>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace textile {
+
+using std::cout;
+using std::string;
+
+/* The capture options of camera in the "key;value|key;value" form the
+ * FFmpeg backend of cv::VideoCapture reads from the environment. */
+static string FfmpegOptions(const CameraConfig& camera) {
+  std::ostringstream options;
+  if (!camera.transport.empty()) {
+    options << "|rtsp_transport;" << camera.transport;
+  }
+  if (camera.probe_size > 0) {
+    options << "|probesize;" << camera.probe_size;
+  }
+  if (camera.analyze_duration_ms >= 0) {
+    options << "|analyzeduration;" << camera.analyze_duration_ms * 1000LL;
+  }
+  if (camera.max_delay_ms >= 0) {
+    options << "|max_delay;" << camera.max_delay_ms * 1000LL;
+  }
+  if (camera.reorder_queue >= 0) {
+    options << "|reorder_queue_size;" << camera.reorder_queue;
+  }
+  if (camera.low_delay) {
+    options << "|fflags;nobuffer|flags;low_delay";
+  }
+  const string joined = options.str();
+  return joined.empty() ? joined : joined.substr(1);
+}
+
+void RTSP_Stream::Init(const CameraConfig& camera) {
+  source = camera.url;
+  ffmpeg_options = FfmpegOptions(camera);
+}
+
+void RTSP_Stream::Open(){
+  if (ffmpeg_options.empty()) {
+    cap.open(source);
+  } else {
+    // The options are process-wide and read when the stream is opened.
+    setenv("OPENCV_FFMPEG_CAPTURE_OPTIONS", ffmpeg_options.c_str(), 1);
+    cap.open(source, cv::CAP_FFMPEG);
+    unsetenv("OPENCV_FFMPEG_CAPTURE_OPTIONS");
+  }
+  if(!cap.isOpened())
+  {
+    cout << "Can't open the stream: " << source << std::endl;
+  }
+
+  //cap.set(CV_CAP_PROP_FRAME_HEIGHT, 768);
+  //cap.set(CV_CAP_PROP_FRAME_WIDTH, 1024);
+
+  return ;
+}
+
+void RTSP_Stream::Reconnect() {
+  cap.release();
+  clock.Reset();
+  Open();
+}
+
+void RTSP_Stream::Read(Frame* frame) {
+  frame->owner.reset();
+  frame->corrupt = false;
+  GetFrame(frame->image);
+  frame->timestamp_us = clock.ToWall(
+      static_cast<int64_t>(cap.get(cv::CAP_PROP_POS_MSEC) * 1000.),
+      WallTimeUs());
+}
+
+void RTSP_Stream::GetFrame(cv::Mat& img){
+
+  cap >> img;
+  if (img.empty())
+  {
+    cout << "Can't get frame: " << source << std::endl;
+  }
+
+}
+
+}  // namespace textile
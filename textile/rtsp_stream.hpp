@@ -0,0 +1,49 @@
+// RTSP camera source built on cv::VideoCapture.
+//
+// The capture settings of the camera's config (transport, probe size,
+// analyze duration, max_delay, reorder queue, low delay) are passed to the
+// FFmpeg backend through OPENCV_FFMPEG_CAPTURE_OPTIONS while the stream is
+// opened; with none set, OpenCV picks the backend and its defaults.
+// cv::VideoCapture does not pass on the decoder's error flags, so frames
+// from it are never marked corrupt, nor the RTCP sender reports: frames
+// are stamped with their PTS (CAP_PROP_POS_MSEC) mapped to the wall clock
+// by a StreamClock.
+//
+#ifndef TEXTILE_RTSP_STREAM_HPP_
+#define TEXTILE_RTSP_STREAM_HPP_
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include <string>
+
+#include "textile/config.hpp"
+#include "textile/frame_source.hpp"
+#include "textile/stream_clock.hpp"
+
+namespace textile {
+
+class RTSP_Stream : public FrameSource {
+ public:
+  RTSP_Stream() {}
+
+  /* Take the stream url from the camera's config. */
+  void Init(const CameraConfig& camera);
+
+  virtual void Open();
+  virtual void Reconnect();
+  /* Frames are decoded into frame->image; nothing is lent. */
+  virtual void Read(Frame* frame);
+
+  void GetFrame(cv::Mat& img);
+
+ private:
+  std::string source;
+  std::string ffmpeg_options;
+  cv::VideoCapture cap;
+  StreamClock clock;
+};
+
+}  // namespace textile
+
+#endif  // TEXTILE_RTSP_STREAM_HPP_
@@ -0,0 +1,109 @@
+#include "textile/speed_estimator.hpp"
+
+#include <math.h>
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <glog/logging.h>
+
+namespace textile {
+
+/* Standard deviation of a shift measured with a sharp peak, in cells. */
+static const double kShiftSigmaCells = 0.1;
+/* Measurements further than this many standard deviations from the
+ * estimate are outliers... */
+static const double kGateSigmas = 3.;
+/* ...unless this many come in a row: then the speed really changed. */
+static const int kMaxRejected = 5;
+
+SpeedEstimator::SpeedEstimator(int cols, int rows, float pixels_per_metre,
+                               int axis, double process_noise,
+                               double min_response)
+    : axis_(axis), pixels_per_metre_(pixels_per_metre),
+      process_noise_(process_noise), min_response_(min_response),
+      sampler_(cols, rows), has_previous_(false), initialized_(false),
+      speed_(0.), variance_(0.), rejected_(0), last_shift_(0.),
+      last_response_(0.) {
+  CHECK_GT(pixels_per_metre, 0.f);
+  CHECK(axis == 0 || axis == 1) << "Bad axis " << axis;
+  cv::createHanningWindow(window_, cv::Size(cols, rows), CV_32F);
+}
+
+double SpeedEstimator::metres_per_minute() const {
+  return initialized_ ? fabs(speed_) * 60. : 0.;
+}
+
+bool SpeedEstimator::Add(const cv::Mat& img, double seconds) {
+  if (img.cols < window_.cols || img.rows < window_.rows) {
+    LOG_FIRST_N(WARNING, 1) << "Frames of " << img.cols << "x" << img.rows
+                            << " are smaller than the speed grid of "
+                            << window_.cols << "x" << window_.rows;
+    return false;
+  }
+  sampler_.Downsample(img.data, img.cols, img.rows,
+                      static_cast<int>(img.step), img.channels(), &grid_);
+  current_.create(grid_.rows, grid_.cols, CV_32F);
+  for (int r = 0; r < grid_.rows; ++r) {
+    const uint8_t* cells = &grid_.cells[r * grid_.cols * grid_.channels];
+    float* luma = current_.ptr<float>(r);
+    for (int c = 0; c < grid_.cols; ++c) {
+      luma[c] = grid_.channels == 1 ? cells[c] :
+          0.114f * cells[3 * c] + 0.587f * cells[3 * c + 1] +
+          0.299f * cells[3 * c + 2];
+    }
+  }
+  if (!has_previous_ || seconds <= 0.) {
+    cv::swap(previous_, current_);
+    has_previous_ = true;
+    return false;
+  }
+
+  // The speed drifts while no measurement comes in.
+  if (initialized_) {
+    variance_ += process_noise_ * seconds;
+  }
+  double response = 0.;
+  const cv::Point2d shift =
+      cv::phaseCorrelate(previous_, current_, window_, &response);
+  cv::swap(previous_, current_);
+  const double cell = axis_ == 0 ?
+      static_cast<double>(img.cols) / grid_.cols :
+      static_cast<double>(img.rows) / grid_.rows;
+  last_shift_ = (axis_ == 0 ? shift.x : shift.y) * cell;
+  last_response_ = response;
+  if (response < min_response_) {
+    return false;
+  }
+  const double metres_per_cell = cell / pixels_per_metre_;
+  const double sigma = kShiftSigmaCells * metres_per_cell / seconds;
+  return Update(last_shift_ / pixels_per_metre_ / seconds,
+                sigma * sigma / response);
+}
+
+bool SpeedEstimator::Update(double z, double r) {
+  if (!initialized_) {
+    speed_ = z;
+    variance_ = r;
+    initialized_ = true;
+    return true;
+  }
+  const double innovation = z - speed_;
+  const double s = variance_ + r;
+  if (innovation * innovation > kGateSigmas * kGateSigmas * s) {
+    if (++rejected_ < kMaxRejected) {
+      return false;
+    }
+    // Start over from the new speed.
+    rejected_ = 0;
+    speed_ = z;
+    variance_ = r;
+    return true;
+  }
+  rejected_ = 0;
+  const double gain = variance_ / s;
+  speed_ += gain * innovation;
+  variance_ *= 1. - gain;
+  return true;
+}
+
+}  // namespace textile
@@ -0,0 +1,77 @@
+// Fabric speed measured from the frames of a camera.
+//
+// Each frame is shrunk to a coarse luma grid (see frame_grid.hpp) and
+// phase-correlated with the previous one: the peak of the inverse FFT of
+// the normalized cross-power spectrum gives the translation, refined to a
+// fraction of a cell by the centroid around it (cv::phaseCorrelate). The
+// shift along the fabric axis over the time between the frames is one
+// speed measurement; a scalar Kalman filter with a random-walk speed
+// smooths them, weighting each by the sharpness of its peak and ignoring
+// those far off the estimate (a splice, a hand in the view) unless they
+// persist.
+//
+// The fabric must move less than half the grid between two frames, so
+// Add() should see every frame, not only the ones that are sampled.
+//
+#ifndef TEXTILE_SPEED_ESTIMATOR_HPP_
+#define TEXTILE_SPEED_ESTIMATOR_HPP_
+
+#include <opencv2/core/core.hpp>
+
+#include "textile/frame_grid.hpp"
+
+namespace textile {
+
+class SpeedEstimator {
+ public:
+  /* The grid is cols x rows cells over the image passed to Add, which shows
+   * pixels_per_metre pixels per metre of fabric along axis (0 is x, 1 is
+   * y). process_noise is the variance, in (m/s)^2, the speed gains per
+   * second; peaks with a response below min_response are ignored. */
+  SpeedEstimator(int cols, int rows, float pixels_per_metre, int axis,
+                 double process_noise, double min_response);
+
+  /* Measure img (8-bit gray or BGR) against the previous image, seconds
+   * earlier. Returns whether the measurement was used; images smaller than
+   * the grid are not. */
+  bool Add(const cv::Mat& img, double seconds);
+
+  /* Whether there is an estimate yet. */
+  bool valid() const { return initialized_; }
+  /* The smoothed speed, in metres per minute; 0 without an estimate. */
+  double metres_per_minute() const;
+  /* The smoothed speed in metres per second, positive when the fabric
+   * moves toward +x or +y. */
+  double metres_per_second() const { return speed_; }
+  /* Shift along the axis, in pixels, and response of the last
+   * measurement. */
+  double last_shift() const { return last_shift_; }
+  double last_response() const { return last_response_; }
+
+ private:
+  /* Fold the measured speed z (m/s) with variance r into the estimate. */
+  bool Update(double z, double r);
+
+  int axis_;
+  float pixels_per_metre_;
+  double process_noise_;
+  double min_response_;
+  GridSampler sampler_;
+  FrameGrid grid_;
+  cv::Mat window_;
+  cv::Mat previous_;
+  cv::Mat current_;
+  bool has_previous_;
+
+  bool initialized_;
+  /* Speed along the axis in m/s, signed, and its variance. */
+  double speed_;
+  double variance_;
+  int rejected_;
+  double last_shift_;
+  double last_response_;
+};
+
+}  // namespace textile
+
+#endif  // TEXTILE_SPEED_ESTIMATOR_HPP_
@@ -0,0 +1,246 @@
+#include "textile/sqlite_sink.hpp"
+
+#include <sqlite3.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "textile/allocator.hpp"
+
+namespace textile {
+
+static const char kSchema[] =
+    "CREATE TABLE IF NOT EXISTS detections ("
+    "  time_ms INTEGER NOT NULL, frame INTEGER, camera TEXT NOT NULL,"
+    "  model TEXT, label INTEGER NOT NULL, score REAL NOT NULL,"
+    "  xmin REAL, ymin REAL, xmax REAL, ymax REAL);"
+    "CREATE INDEX IF NOT EXISTS detections_camera_time"
+    "  ON detections (camera, time_ms);"
+    "CREATE INDEX IF NOT EXISTS detections_time ON detections (time_ms);"
+    "CREATE INDEX IF NOT EXISTS detections_label_time"
+    "  ON detections (label, time_ms);"
+    "CREATE TABLE IF NOT EXISTS events ("
+    "  time_ms INTEGER NOT NULL, camera TEXT NOT NULL, kind TEXT NOT NULL,"
+    "  detail TEXT);"
+    "CREATE INDEX IF NOT EXISTS events_camera_time"
+    "  ON events (camera, time_ms);";
+
+/* The strings outlive the statement step, so SQLite need not copy them. */
+static void BindText(sqlite3_stmt* s, int column, const std::string& text) {
+  sqlite3_bind_text(s, column, text.data(), static_cast<int>(text.size()),
+                    SQLITE_STATIC);
+}
+
+SqliteSink::SqliteSink(const std::string& path, int max_queued,
+                       int commit_interval_ms)
+    : db_(NULL), insert_detection_(NULL), insert_event_(NULL),
+      max_queued_(max_queued), commit_interval_ms_(commit_interval_ms),
+      accepted_(0), done_(0), written_(0), dropped_(0), failed_(0),
+      transactions_(0), flush_target_(0), stop_(false),
+      queue_gauge_(kMemQueues) {
+  CHECK_EQ(sqlite3_open(path.c_str(), &db_), SQLITE_OK)
+    << "Unable to open " << path << ": " << sqlite3_errmsg(db_);
+  sqlite3_busy_timeout(db_, 5000);
+  CHECK(Exec("PRAGMA journal_mode=WAL"));
+  // With WAL, NORMAL only risks the last transactions on power loss, not
+  // the integrity of the database.
+  CHECK(Exec("PRAGMA synchronous=NORMAL"));
+  CHECK(Exec(kSchema));
+  CHECK_EQ(sqlite3_prepare_v2(db_,
+      "INSERT INTO detections (time_ms, frame, camera, model, label, score,"
+      " xmin, ymin, xmax, ymax) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)",
+      -1, &insert_detection_, NULL), SQLITE_OK) << sqlite3_errmsg(db_);
+  CHECK_EQ(sqlite3_prepare_v2(db_,
+      "INSERT INTO events (time_ms, camera, kind, detail)"
+      " VALUES (?, ?, ?, ?)",
+      -1, &insert_event_, NULL), SQLITE_OK) << sqlite3_errmsg(db_);
+  writer_ = std::thread(&SqliteSink::WriterLoop, this);
+}
+
+SqliteSink::~SqliteSink() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  queued_cv_.notify_one();
+  writer_.join();
+  sqlite3_finalize(insert_detection_);
+  sqlite3_finalize(insert_event_);
+  sqlite3_close(db_);
+}
+
+void SqliteSink::UpdateQueueGauge() {
+  // Both queues swap with the writer's, so each side holds about this.
+  queue_gauge_.Update(2 * static_cast<int64_t>(
+      detections_.capacity() * sizeof(DetectionRecord) +
+      events_.capacity() * sizeof(EventRecord)));
+}
+
+bool SqliteSink::Exec(const char* sql) {
+  char* error = NULL;
+  if (sqlite3_exec(db_, sql, NULL, NULL, &error) != SQLITE_OK) {
+    LOG(WARNING) << "sqlite: " << (error != NULL ? error : "") << " in: "
+                 << sql;
+    sqlite3_free(error);
+    return false;
+  }
+  return true;
+}
+
+void SqliteSink::Write(const std::vector<DetectionRecord>& records) {
+  if (records.empty()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (detections_.size() + records.size() >
+        static_cast<size_t>(max_queued_)) {
+      dropped_ += records.size();
+      return;
+    }
+    detections_.insert(detections_.end(), records.begin(), records.end());
+    accepted_ += records.size();
+    UpdateQueueGauge();
+  }
+  queued_cv_.notify_one();
+}
+
+void SqliteSink::WriteEvent(const EventRecord& event) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_.push_back(event);
+    ++accepted_;
+    UpdateQueueGauge();
+  }
+  queued_cv_.notify_one();
+}
+
+void SqliteSink::Flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  const int64_t target = accepted_;
+  flush_target_ = target;
+  queued_cv_.notify_one();
+  committed_cv_.wait(lock, [&] { return done_ >= target; });
+}
+
+void SqliteSink::WriterLoop() {
+  BindThreadArena();
+  std::vector<DetectionRecord> detections;
+  std::vector<EventRecord> events;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      queued_cv_.wait(lock, [&] {
+        return stop_ || !detections_.empty() || !events_.empty();
+      });
+      if (!stop_) {
+        // Let rows accumulate so that each transaction is large, unless
+        // the queue fills up first or someone is waiting in Flush.
+        const std::chrono::steady_clock::time_point deadline =
+            std::chrono::steady_clock::now() +
+            std::chrono::milliseconds(commit_interval_ms_);
+        queued_cv_.wait_until(lock, deadline, [&] {
+          return stop_ || accepted_ - done_ > max_queued_ / 2 ||
+              flush_target_ > done_;
+        });
+      }
+      if (detections_.empty() && events_.empty()) {
+        if (stop_) {
+          return;
+        }
+        continue;
+      }
+      // The queue keeps its capacity: the vectors swap back and forth.
+      detections.swap(detections_);
+      events.swap(events_);
+    }
+    Commit(detections, events);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_ += detections.size() + events.size();
+    }
+    committed_cv_.notify_all();
+    detections.clear();
+    events.clear();
+  }
+}
+
+void SqliteSink::Commit(const std::vector<DetectionRecord>& detections,
+                        const std::vector<EventRecord>& events) {
+  const int64_t rows = detections.size() + events.size();
+  int64_t failed = 0;
+  if (!Exec("BEGIN")) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    failed_ += rows;
+    return;
+  }
+  for (size_t i = 0; i < detections.size(); ++i) {
+    const DetectionRecord& r = detections[i];
+    sqlite3_stmt* s = insert_detection_;
+    sqlite3_bind_int64(s, 1, r.time_ms);
+    sqlite3_bind_int64(s, 2, r.frame);
+    BindText(s, 3, r.camera);
+    BindText(s, 4, r.model);
+    sqlite3_bind_int(s, 5, r.label);
+    sqlite3_bind_double(s, 6, r.score);
+    sqlite3_bind_double(s, 7, r.xmin);
+    sqlite3_bind_double(s, 8, r.ymin);
+    sqlite3_bind_double(s, 9, r.xmax);
+    sqlite3_bind_double(s, 10, r.ymax);
+    if (sqlite3_step(s) != SQLITE_DONE) {
+      ++failed;
+    }
+    sqlite3_reset(s);
+  }
+  for (size_t i = 0; i < events.size(); ++i) {
+    const EventRecord& e = events[i];
+    sqlite3_stmt* s = insert_event_;
+    sqlite3_bind_int64(s, 1, e.time_ms);
+    BindText(s, 2, e.camera);
+    BindText(s, 3, e.kind);
+    BindText(s, 4, e.detail);
+    if (sqlite3_step(s) != SQLITE_DONE) {
+      ++failed;
+    }
+    sqlite3_reset(s);
+  }
+  if (failed > 0) {
+    LOG(WARNING) << "sqlite: " << failed << " inserts failed: "
+                 << sqlite3_errmsg(db_);
+  }
+  if (!Exec("COMMIT")) {
+    Exec("ROLLBACK");
+    failed = rows;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  written_ += rows - failed;
+  failed_ += failed;
+  ++transactions_;
+}
+
+int64_t SqliteSink::rows_written() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return written_;
+}
+
+int64_t SqliteSink::rows_dropped() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return dropped_;
+}
+
+void SqliteSink::ExportMetrics(Metrics* metrics) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  metrics->Set("textile_sink_rows_written_total{sink=\"sqlite\"}", written_);
+  metrics->Set("textile_sink_rows_dropped_total{sink=\"sqlite\"}", dropped_);
+  metrics->Set("textile_sink_rows_failed_total{sink=\"sqlite\"}", failed_);
+  metrics->Set("textile_sink_transactions_total{sink=\"sqlite\"}",
+               transactions_);
+  metrics->Set("textile_sink_queued_rows{sink=\"sqlite\"}",
+               detections_.size() + events_.size());
+}
+
+}  // namespace textile
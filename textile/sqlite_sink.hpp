@@ -0,0 +1,92 @@
+// SQLite result sink.
+//
+// Write() only appends to an in-memory queue; a writer thread owns the
+// database and inserts everything queued since its last commit in one
+// transaction with prepared statements. The database runs in WAL mode so
+// readers (dashboards, sqlite3 shells) do not hold the writer up. When
+// the queue is full, new rows are dropped and counted instead of making
+// the inference loop wait for the disk.
+//
+//    CREATE TABLE detections (time_ms, frame, camera, model, label, score,
+//                             xmin, ymin, xmax, ymax)
+//    CREATE TABLE events (time_ms, camera, kind, detail)
+//
+// with indexes on (camera, time_ms), (time_ms) and (label, time_ms).
+//
+#ifndef TEXTILE_SQLITE_SINK_HPP_
+#define TEXTILE_SQLITE_SINK_HPP_
+
+#include <stdint.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "textile/detection_sink.hpp"
+#include "textile/memory_profile.hpp"
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+namespace textile {
+
+class SqliteSink : public DetectionSink {
+ public:
+  /* Open (or create) the database at path. max_queued is the number of
+   * rows the queue holds before dropping; a transaction is committed
+   * every commit_interval_ms at most. */
+  SqliteSink(const std::string& path, int max_queued,
+             int commit_interval_ms);
+  virtual ~SqliteSink();
+
+  virtual void Write(const std::vector<DetectionRecord>& records);
+  virtual void WriteEvent(const EventRecord& event);
+
+  /* Wait until everything queued so far is committed. */
+  virtual void Flush();
+
+  virtual void ExportMetrics(Metrics* metrics) const;
+
+  int64_t rows_written() const;
+  int64_t rows_dropped() const;
+
+ private:
+  void WriterLoop();
+  /* Insert detections and events in one transaction. */
+  void Commit(const std::vector<DetectionRecord>& detections,
+              const std::vector<EventRecord>& events);
+  /* Run sql, logging any error. */
+  bool Exec(const char* sql);
+  /* Report the queue to the memory profile; called under mutex_. */
+  void UpdateQueueGauge();
+
+  sqlite3* db_;
+  sqlite3_stmt* insert_detection_;
+  sqlite3_stmt* insert_event_;
+  int max_queued_;
+  int commit_interval_ms_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable queued_cv_;
+  std::condition_variable committed_cv_;
+  std::vector<DetectionRecord> detections_;
+  std::vector<EventRecord> events_;
+  /* Rows taken by Write, and rows the writer has finished with. */
+  int64_t accepted_;
+  int64_t done_;
+  int64_t written_;
+  int64_t dropped_;
+  int64_t failed_;
+  int64_t transactions_;
+  /* Set by Flush: commit without waiting for more rows. */
+  int64_t flush_target_;
+  bool stop_;
+  MemoryGauge queue_gauge_;
+  std::thread writer_;
+};
+
+}  // namespace textile
+
+#endif  // TEXTILE_SQLITE_SINK_HPP_
@@ -0,0 +1,45 @@
+#include "textile/stream_clock.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace textile {
+
+/* How fast the offset estimate may rise, in microseconds per second: the
+ * clock of a sender may run this much slower than ours. */
+static const double kDriftUsPerSecond = 100.;
+/* A PTS this far past the previous one is a new stream. */
+static const int64_t kMaxPtsGapUs = 10 * 1000000LL;
+
+int64_t WallTimeUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+StreamClock::StreamClock()
+    : valid_(false), offset_us_(0), last_pts_us_(0), last_arrival_us_(0) {}
+
+void StreamClock::Reset() {
+  valid_ = false;
+}
+
+int64_t StreamClock::ToWall(int64_t pts_us, int64_t arrival_us) {
+  if (valid_ && pts_us == last_pts_us_) {
+    return arrival_us;
+  }
+  const int64_t offset = arrival_us - pts_us;
+  if (!valid_ || pts_us < last_pts_us_ ||
+      pts_us - last_pts_us_ > kMaxPtsGapUs) {
+    offset_us_ = offset;
+    valid_ = true;
+  } else {
+    offset_us_ += static_cast<int64_t>(
+        kDriftUsPerSecond * (arrival_us - last_arrival_us_) / 1e6);
+    offset_us_ = std::min(offset_us_, offset);
+  }
+  last_pts_us_ = pts_us;
+  last_arrival_us_ = arrival_us;
+  return pts_us + offset_us_;
+}
+
+}  // namespace textile
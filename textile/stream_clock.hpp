@@ -0,0 +1,54 @@
+// Wall-clock capture times of the frames of a stream.
+//
+// Streams stamp their frames with presentation times (PTS) on a clock of
+// their own. StreamClock maps them to the wall clock with an estimate of
+// the offset between the two: each frame gives arrival - pts, which is the
+// offset plus the delay of that frame through network, jitter buffer and
+// decoder. The delay is never negative, so the running minimum, the frame
+// that came through fastest, is the best estimate; it is let up by a
+// little per second, so that it follows a sender clock running slow. A
+// jump back or a long gap in the PTS (a reconnect, a wrapped clock) starts
+// the estimate over.
+//
+// The result is the capture time plus the smallest delay seen, the same
+// for cameras on the same network and decoder, so frames of different
+// cameras taken at the same moment get close timestamps. Sources that know
+// the sender's NTP time from its RTCP sender reports use that instead
+// (see gst_stream.hpp).
+//
+#ifndef TEXTILE_STREAM_CLOCK_HPP_
+#define TEXTILE_STREAM_CLOCK_HPP_
+
+#include <stdint.h>
+
+namespace textile {
+
+/* Microseconds since the epoch. */
+int64_t WallTimeUs();
+
+class StreamClock {
+ public:
+  StreamClock();
+
+  /* The wall time, in microseconds since the epoch, of a frame with
+   * presentation time pts_us on the stream's clock that arrived at
+   * arrival_us. Frames whose PTS does not advance get arrival_us. */
+  int64_t ToWall(int64_t pts_us, int64_t arrival_us);
+
+  /* Forget the offset, e.g. after reconnecting. */
+  void Reset();
+
+  bool valid() const { return valid_; }
+  /* Wall time minus stream time. */
+  int64_t offset_us() const { return offset_us_; }
+
+ private:
+  bool valid_;
+  int64_t offset_us_;
+  int64_t last_pts_us_;
+  int64_t last_arrival_us_;
+};
+
+}  // namespace textile
+
+#endif  // TEXTILE_STREAM_CLOCK_HPP_
@@ -0,0 +1,81 @@
+#include "textile/tracker.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace textile {
+
+float BoxIoU(const Detection& a, const Detection& b) {
+  const float w = std::min(a.xmax, b.xmax) - std::max(a.xmin, b.xmin);
+  const float h = std::min(a.ymax, b.ymax) - std::max(a.ymin, b.ymin);
+  if (w <= 0.f || h <= 0.f) {
+    return 0.f;
+  }
+  const float inter = w * h;
+  const float area_a = (a.xmax - a.xmin) * (a.ymax - a.ymin);
+  const float area_b = (b.xmax - b.xmin) * (b.ymax - b.ymin);
+  return inter / (area_a + area_b - inter);
+}
+
+IouTracker::IouTracker(float min_iou, int max_misses)
+    : min_iou_(min_iou), max_misses_(max_misses), next_id_(1), started_(0) {}
+
+void IouTracker::Update(const std::vector<ModelDetection>& detections) {
+  matched_.assign(detections.size(), false);
+  for (size_t t = 0; t < tracks_.size(); ++t) {
+    Track& track = tracks_[t];
+    int best = -1;
+    float best_iou = min_iou_;
+    for (size_t i = 0; i < detections.size(); ++i) {
+      const ModelDetection& d = detections[i];
+      if (matched_[i] || d.model != track.model ||
+          d.detection.label != track.box.label) {
+        continue;
+      }
+      const float iou = BoxIoU(d.detection, track.box);
+      if (iou >= best_iou) {
+        best = static_cast<int>(i);
+        best_iou = iou;
+      }
+    }
+    if (best < 0) {
+      ++track.misses;
+      continue;
+    }
+    matched_[best] = true;
+    track.box = detections[best].detection;
+    ++track.hits;
+    track.misses = 0;
+  }
+
+  tracks_.erase(std::remove_if(tracks_.begin(), tracks_.end(),
+      [this](const Track& track) { return track.misses > max_misses_; }),
+      tracks_.end());
+
+  started_ = 0;
+  for (size_t i = 0; i < detections.size(); ++i) {
+    if (matched_[i]) {
+      continue;
+    }
+    Track track;
+    track.id = next_id_++;
+    track.model = detections[i].model;
+    track.box = detections[i].detection;
+    track.hits = 1;
+    track.misses = 0;
+    tracks_.push_back(track);
+    ++started_;
+  }
+}
+
+void IouTracker::Shift(float dx, float dy) {
+  for (size_t t = 0; t < tracks_.size(); ++t) {
+    Detection& box = tracks_[t].box;
+    box.xmin += dx;
+    box.xmax += dx;
+    box.ymin += dy;
+    box.ymax += dy;
+  }
+}
+
+}  // namespace textile
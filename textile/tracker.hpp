@@ -0,0 +1,61 @@
+// Frame-to-frame association of detections.
+//
+// IouTracker matches the detections of a frame to the tracks of the
+// previous ones greedily by overlap (same model and label only). Unmatched
+// detections start new tracks; a track that goes unmatched for more than
+// max_misses frames is dropped. This is enough to follow a defect while it
+// crosses the field of view of a camera.
+//
+#ifndef TEXTILE_TRACKER_HPP_
+#define TEXTILE_TRACKER_HPP_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "textile/detector.hpp"
+#include "textile/multi_model.hpp"
+
+namespace textile {
+
+/* Intersection over union of two boxes. */
+float BoxIoU(const Detection& a, const Detection& b);
+
+struct Track {
+  int64_t id;
+  int model;
+  /* The last box matched, in frame coordinates. */
+  Detection box;
+  /* Frames matched, and consecutive frames missed since. */
+  int hits;
+  int misses;
+};
+
+class IouTracker {
+ public:
+  IouTracker(float min_iou, int max_misses);
+
+  /* Advance by one frame with its detections in frame coordinates. */
+  void Update(const std::vector<ModelDetection>& detections);
+
+  /* Move every track by (dx, dy) pixels: the motion of the scene since the
+   * last frame, so that tracks match on frames far apart. */
+  void Shift(float dx, float dy);
+
+  const std::vector<Track>& tracks() const { return tracks_; }
+  /* Tracks the last Update started: the defects seen for the first time. */
+  int started() const { return started_; }
+
+ private:
+  float min_iou_;
+  int max_misses_;
+  int64_t next_id_;
+  std::vector<Track> tracks_;
+  int started_;
+  /* Scratch of Update. */
+  std::vector<bool> matched_;
+};
+
+}  // namespace textile
+
+#endif  // TEXTILE_TRACKER_HPP_
@@ -0,0 +1,593 @@
+// Micro-benchmarks of the pipeline components.
+// Usage:
+//    textile_bench [FLAGS] -bench name
+//
+// sqlite: sustained inserts/sec of SqliteSink and the latency of its
+//         Write(), which the inference loop pays. With -bench_rate the
+//         producer is paced at that many detections per second, to check
+//         that a given peak rate is absorbed without drops.
+// nms:    IoU matrix, greedy NMS and soft-NMS of BoxSuppressor on
+//         -bench_boxes clustered boxes with every kernel variant the CPU
+//         supports, after checking all three against plain scalar
+//         implementations (the matrix and soft-NMS up to 2000 boxes).
+// grid:   GridSampler::Downsample of a 1080p BGR frame and of the Y plane
+//         of an NV12 one to a -bench_grid grid, and CompareGrids, with
+//         every kernel variant the CPU supports, after checking the cells
+//         against a plain mean over each cell.
+// heap:   soak of the heap allocator: -bench_threads threads, each bound
+//         to an arena, churn frame-sized buffers and small detection
+//         vectors the way the pipeline does, for -bench_seconds (run it
+//         for hours to soak). Prints heap and RSS every -bench_report_s
+//         and fails when RSS at the end exceeds -bench_max_growth times
+//         RSS after the first report.
+//
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "textile/allocator.hpp"
+#include "textile/box_set.hpp"
+#include "textile/detection_sink.hpp"
+#include "textile/frame_grid.hpp"
+#include "textile/kernels.hpp"
+#include "textile/memory_profile.hpp"
+#ifdef USE_SQLITE
+#include "textile/sqlite_sink.hpp"
+#endif  // USE_SQLITE
+
+using std::string;
+using std::vector;
+
+DEFINE_string(bench, "",
+    "The benchmark to run: sqlite, nms, grid or heap.");
+DEFINE_double(bench_seconds, 5., "How long to run the benchmark.");
+DEFINE_int32(bench_rate, 0,
+    "sqlite: detections per second to offer; 0 offers as many as possible.");
+DEFINE_int32(bench_frame_rows, 8, "sqlite: detections per Write() call.");
+DEFINE_int32(bench_cameras, 8, "sqlite: cameras the detections come from.");
+DEFINE_string(bench_db, "/tmp/textile_bench.db", "sqlite: database file.");
+DEFINE_int32(bench_queue, 100000, "sqlite: queue size of the sink.");
+DEFINE_int32(bench_commit_ms, 500, "sqlite: commit interval of the sink.");
+DEFINE_string(bench_boxes, "100,1000,10000",
+    "nms: comma-separated numbers of boxes to run with.");
+DEFINE_double(bench_nms_iou, 0.45, "nms: IoU above which NMS suppresses.");
+DEFINE_string(bench_grid, "64x36", "grid: columns x rows of the grid.");
+DEFINE_int32(bench_threads, 8, "heap: threads allocating.");
+DEFINE_int32(bench_arenas, 0, "heap: cap on malloc arenas, 0 for none.");
+DEFINE_int64(bench_mmap_threshold, 1 << 20,
+    "heap: glibc mmap threshold in bytes, 0 for the dynamic one.");
+DEFINE_double(bench_report_s, 10., "heap: seconds between two reports.");
+DEFINE_double(bench_max_growth, 1.5,
+    "heap: largest RSS at the end over RSS at the first report.");
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double Seconds(Clock::duration d) {
+  return std::chrono::duration<double>(d).count();
+}
+
+/* Print percentiles of latencies (in seconds) as microseconds. */
+void PrintLatencies(const string& what, vector<double>* latencies) {
+  if (latencies->empty()) {
+    return;
+  }
+  std::sort(latencies->begin(), latencies->end());
+  const size_t n = latencies->size();
+  printf("%s latency: p50 %.1f us, p99 %.1f us, max %.1f us\n", what.c_str(),
+         (*latencies)[n / 2] * 1e6, (*latencies)[n * 99 / 100] * 1e6,
+         (*latencies)[n - 1] * 1e6);
+}
+
+#ifdef USE_SQLITE
+int BenchSqlite() {
+  remove(FLAGS_bench_db.c_str());
+  remove((FLAGS_bench_db + "-wal").c_str());
+  remove((FLAGS_bench_db + "-shm").c_str());
+  textile::SqliteSink sink(FLAGS_bench_db, FLAGS_bench_queue,
+                           FLAGS_bench_commit_ms);
+
+  vector<textile::DetectionRecord> records(FLAGS_bench_frame_rows);
+  for (size_t i = 0; i < records.size(); ++i) {
+    records[i].model = "main";
+    records[i].label = static_cast<int>(i % 4);
+    records[i].score = 0.5f + 0.05f * (i % 10);
+    records[i].xmin = 100.f;
+    records[i].ymin = 120.f;
+    records[i].xmax = 180.f;
+    records[i].ymax = 200.f;
+  }
+  vector<string> cameras;
+  for (int c = 0; c < FLAGS_bench_cameras; ++c) {
+    cameras.push_back("loom" + std::to_string(c + 1));
+  }
+
+  vector<double> latencies;
+  int64_t offered = 0;
+  int64_t frame = 0;
+  const Clock::time_point start = Clock::now();
+  const Clock::time_point end =
+      start + std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(FLAGS_bench_seconds));
+  while (Clock::now() < end) {
+    if (FLAGS_bench_rate > 0) {
+      const Clock::time_point due = start +
+          std::chrono::duration_cast<Clock::duration>(
+              std::chrono::duration<double>(
+                  static_cast<double>(offered) / FLAGS_bench_rate));
+      std::this_thread::sleep_until(due);
+    }
+    const int64_t now = textile::WallTimeMs();
+    const string& camera = cameras[frame % cameras.size()];
+    for (size_t i = 0; i < records.size(); ++i) {
+      records[i].time_ms = now;
+      records[i].frame = frame;
+      records[i].camera = camera;
+    }
+    const Clock::time_point before = Clock::now();
+    sink.Write(records);
+    latencies.push_back(Seconds(Clock::now() - before));
+    offered += records.size();
+    ++frame;
+  }
+  const double produce_seconds = Seconds(Clock::now() - start);
+  sink.Flush();
+  const double total_seconds = Seconds(Clock::now() - start);
+
+  printf("sqlite: offered %lld detections in %.2f s (%.0f/s)\n",
+         static_cast<long long>(offered), produce_seconds,
+         offered / produce_seconds);
+  printf("sqlite: written %lld (%.0f inserts/s sustained, including the"
+         " final flush), dropped %lld\n",
+         static_cast<long long>(sink.rows_written()),
+         sink.rows_written() / total_seconds,
+         static_cast<long long>(sink.rows_dropped()));
+  PrintLatencies("Write()", &latencies);
+  return sink.rows_dropped() == 0 ? 0 : 2;
+}
+#endif  // USE_SQLITE
+
+/* Boxes as a detector emits them before NMS: clusters of jittered boxes
+ * around a few objects of a 1920x1080 frame, with 4 labels. */
+void MakeBoxes(int n, textile::BoxSet* boxes) {
+  boxes->Clear();
+  boxes->Reserve(n);
+  const int clusters = std::max(n / 16, 1);
+  for (int i = 0; i < n; ++i) {
+    srand(i % clusters + 1);
+    const float cx = static_cast<float>(rand() % 1920);
+    const float cy = static_cast<float>(rand() % 1080);
+    const float size = 16.f + rand() % 200;
+    srand(i + 1000003);
+    const float jx = (rand() % 201 - 100) / 400.f * size;
+    const float jy = (rand() % 201 - 100) / 400.f * size;
+    const float half = size * (0.4f + (rand() % 21) / 100.f);
+    boxes->Add(rand() % 4, (rand() % 10000) / 10000.f, cx + jx - half,
+               cy + jy - half, cx + jx + half, cy + jy + half);
+  }
+}
+
+/* Greedy NMS in the most direct way, to check BoxSuppressor::Nms. */
+void ReferenceNms(const textile::BoxSet& boxes, float max_iou,
+                  bool class_aware, vector<int>* keep) {
+  vector<int> order(boxes.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = static_cast<int>(i);
+  }
+  const float* score = boxes.score();
+  std::sort(order.begin(), order.end(), [&](int a, int b) {
+    return score[a] != score[b] ? score[a] > score[b] : a < b;
+  });
+  keep->clear();
+  for (size_t o = 0; o < order.size(); ++o) {
+    const int i = order[o];
+    bool suppressed = false;
+    for (size_t k = 0; k < keep->size() && !suppressed; ++k) {
+      const int j = (*keep)[k];
+      if (class_aware && boxes.label()[i] != boxes.label()[j]) {
+        continue;
+      }
+      float iou;
+      textile::kScalarKernels.iou_row(boxes.xmin()[j], boxes.ymin()[j],
+          boxes.xmax()[j], boxes.ymax()[j], boxes.area()[j],
+          boxes.xmin() + i, boxes.ymin() + i, boxes.xmax() + i,
+          boxes.ymax() + i, boxes.area() + i, 1, &iou);
+      suppressed = iou > max_iou;
+    }
+    if (!suppressed) {
+      keep->push_back(i);
+    }
+  }
+}
+
+/* Gaussian soft-NMS in the most direct way, to check
+ * BoxSuppressor::SoftNms: the best remaining box by decayed score (ties to
+ * the higher original score, then the lower index) is kept and decays the
+ * others. */
+void ReferenceSoftNms(const textile::BoxSet& boxes, float sigma,
+                      float min_score, bool class_aware, vector<int>* keep,
+                      vector<float>* scores) {
+  const int n = boxes.size();
+  const float* score = boxes.score();
+  const int* label = boxes.label();
+  vector<float> decayed(score, score + n);
+  vector<bool> active(n);
+  vector<int> labels;
+  for (int i = 0; i < n; ++i) {
+    active[i] = score[i] >= min_score;
+    labels.push_back(class_aware ? label[i] : 0);
+  }
+  std::sort(labels.begin(), labels.end());
+  labels.erase(std::unique(labels.begin(), labels.end()), labels.end());
+  keep->clear();
+  scores->clear();
+  for (size_t l = 0; l < labels.size(); ++l) {
+    while (true) {
+      int best = -1;
+      for (int i = 0; i < n; ++i) {
+        if (!active[i] || (class_aware && label[i] != labels[l])) {
+          continue;
+        }
+        if (best < 0 || decayed[i] > decayed[best] ||
+            (decayed[i] == decayed[best] && score[i] > score[best])) {
+          best = i;
+        }
+      }
+      if (best < 0) {
+        break;
+      }
+      active[best] = false;
+      keep->push_back(best);
+      scores->push_back(decayed[best]);
+      for (int j = 0; j < n; ++j) {
+        if (!active[j] || (class_aware && label[j] != labels[l])) {
+          continue;
+        }
+        float iou;
+        textile::kScalarKernels.iou_row(boxes.xmin()[best],
+            boxes.ymin()[best], boxes.xmax()[best], boxes.ymax()[best],
+            boxes.area()[best], boxes.xmin() + j, boxes.ymin() + j,
+            boxes.xmax() + j, boxes.ymax() + j, boxes.area() + j, 1, &iou);
+        if (iou > 0.f) {
+          decayed[j] *= expf(-iou * iou / sigma);
+          active[j] = decayed[j] >= min_score;
+        }
+      }
+    }
+  }
+  if (class_aware && labels.size() > 1) {
+    vector<int> order(keep->size());
+    for (size_t i = 0; i < order.size(); ++i) {
+      order[i] = static_cast<int>(i);
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+      return (*scores)[a] != (*scores)[b] ? (*scores)[a] > (*scores)[b] :
+          (*keep)[a] < (*keep)[b];
+    });
+    vector<int> sorted_keep;
+    vector<float> sorted_scores;
+    for (size_t i = 0; i < order.size(); ++i) {
+      sorted_keep.push_back((*keep)[order[i]]);
+      sorted_scores.push_back((*scores)[order[i]]);
+    }
+    keep->swap(sorted_keep);
+    scores->swap(sorted_scores);
+  }
+}
+
+/* Whether iou holds the IoU of every pair of boxes, computed one pair at a
+ * time. */
+bool IouMatrixMatches(const textile::BoxSet& boxes,
+                      const vector<float>& iou) {
+  const int n = boxes.size();
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      float expected;
+      textile::kScalarKernels.iou_row(boxes.xmin()[i], boxes.ymin()[i],
+          boxes.xmax()[i], boxes.ymax()[i], boxes.area()[i],
+          boxes.xmin() + j, boxes.ymin() + j, boxes.xmax() + j,
+          boxes.ymax() + j, boxes.area() + j, 1, &expected);
+      if (iou[static_cast<size_t>(i) * n + j] != expected) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/* Mean seconds per call of run, repeated for about seconds. */
+template <typename Fn>
+double TimePerCall(double seconds, Fn run) {
+  const Clock::time_point start = Clock::now();
+  int64_t calls = 0;
+  do {
+    run();
+    ++calls;
+  } while (Seconds(Clock::now() - start) < seconds);
+  return Seconds(Clock::now() - start) / calls;
+}
+
+int BenchNms() {
+  vector<int> counts;
+  std::stringstream ss(FLAGS_bench_boxes);
+  string item;
+  while (getline(ss, item, ',')) {
+    counts.push_back(atoi(item.c_str()));
+  }
+  const double seconds = FLAGS_bench_seconds / 10.;
+  textile::BoxSet boxes;
+  vector<int> keep, expected;
+  vector<float> scores, expected_scores, iou;
+  bool ok = true;
+  for (size_t c = 0; c < counts.size(); ++c) {
+    const int n = counts[c];
+    MakeBoxes(n, &boxes);
+    for (int level = textile::kCpuScalar; level < textile::kNumCpuLevels;
+         ++level) {
+      const textile::Kernels* kernels =
+          textile::KernelsForLevel(static_cast<textile::CpuLevel>(level));
+      if (kernels == NULL) {
+        continue;
+      }
+      textile::BoxSuppressor suppressor(*kernels);
+      const char* name = textile::CpuLevelName(kernels->level);
+      for (int class_aware = 0; class_aware < 2; ++class_aware) {
+        ReferenceNms(boxes, FLAGS_bench_nms_iou, class_aware, &expected);
+        suppressor.Nms(boxes, FLAGS_bench_nms_iou, class_aware, &keep);
+        if (keep != expected) {
+          printf("nms %d boxes %s%s: MISMATCH with the reference\n", n,
+                 name, class_aware ? " class-aware" : "");
+          ok = false;
+        }
+        // Soft-NMS scans every remaining box per kept one: keep it short.
+        if (n <= 2000) {
+          ReferenceSoftNms(boxes, 0.5f, 0.001f, class_aware, &expected,
+                           &expected_scores);
+          suppressor.SoftNms(boxes, 0.5f, 0.001f, class_aware, &keep,
+                             &scores);
+          if (keep != expected || scores != expected_scores) {
+            printf("soft-nms %d boxes %s%s: MISMATCH with the reference\n",
+                   n, name, class_aware ? " class-aware" : "");
+            ok = false;
+          }
+        }
+      }
+      // The matrix of 10k boxes is 400 MB; rows are what NMS runs anyway.
+      if (n <= 2000) {
+        suppressor.IouMatrix(boxes, &iou);
+        if (!IouMatrixMatches(boxes, iou)) {
+          printf("iou matrix %d boxes %s: MISMATCH with the reference\n", n,
+                 name);
+          ok = false;
+        }
+      }
+      printf("nms %5d boxes %-6s: ", n, name);
+      if (n <= 2000) {
+        const double matrix = TimePerCall(seconds, [&] {
+          suppressor.IouMatrix(boxes, &iou);
+        });
+        printf("iou matrix %9.1f us, ", matrix * 1e6);
+      }
+      const double nms = TimePerCall(seconds, [&] {
+        suppressor.Nms(boxes, FLAGS_bench_nms_iou, false, &keep);
+      });
+      const size_t kept = keep.size();
+      const double nms_class = TimePerCall(seconds, [&] {
+        suppressor.Nms(boxes, FLAGS_bench_nms_iou, true, &keep);
+      });
+      const double soft = TimePerCall(seconds, [&] {
+        suppressor.SoftNms(boxes, 0.5f, 0.001f, false, &keep, &scores);
+      });
+      printf("nms %8.1f us (%d kept), class-aware %8.1f us,"
+             " soft-nms %9.1f us\n", nms * 1e6, static_cast<int>(kept),
+             nms_class * 1e6, soft * 1e6);
+    }
+  }
+  return ok ? 0 : 2;
+}
+
+/* Cell means computed the obvious way, to check GridSampler. */
+bool GridMatchesMeans(const vector<uint8_t>& frame, int width, int height,
+                      int channels, const textile::FrameGrid& grid) {
+  for (int r = 0; r < grid.rows; ++r) {
+    const int y0 = height * r / grid.rows;
+    const int y1 = height * (r + 1) / grid.rows;
+    for (int c = 0; c < grid.cols; ++c) {
+      const int x0 = width * c / grid.cols;
+      const int x1 = width * (c + 1) / grid.cols;
+      const uint32_t area = (x1 - x0) * (y1 - y0);
+      for (int k = 0; k < channels; ++k) {
+        uint32_t sum = 0;
+        for (int y = y0; y < y1; ++y) {
+          for (int x = x0; x < x1; ++x) {
+            sum += frame[(y * width + x) * channels + k];
+          }
+        }
+        if (grid.cells[(r * grid.cols + c) * channels + k] !=
+            (sum + area / 2) / area) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+int BenchGrid() {
+  int cols = 0;
+  int rows = 0;
+  char x = 0;
+  if (sscanf(FLAGS_bench_grid.c_str(), "%d%c%d", &cols, &x, &rows) != 3 ||
+      x != 'x' || cols < 1 || rows < 1) {
+    std::cerr << "Bad -bench_grid " << FLAGS_bench_grid << std::endl;
+    return 1;
+  }
+  const int width = 1920;
+  const int height = 1080;
+  const double seconds = FLAGS_bench_seconds / 10.;
+  // A smooth gradient with noise, and the same shifted by a few pixels as
+  // the next frame.
+  vector<uint8_t> frames[2];
+  for (int f = 0; f < 2; ++f) {
+    frames[f].resize(width * height * 3);
+    for (int y = 0; y < height; ++y) {
+      for (int i = 0; i < width * 3; ++i) {
+        frames[f][y * width * 3 + i] = static_cast<uint8_t>(
+            (i / 3 + 5 * f) / 8 + y / 8 + rand() % 16);
+      }
+    }
+  }
+  bool ok = true;
+  textile::FrameGrid grids[2];
+  textile::GridDiff diff;
+  for (int level = textile::kCpuScalar; level < textile::kNumCpuLevels;
+       ++level) {
+    const textile::Kernels* kernels =
+        textile::KernelsForLevel(static_cast<textile::CpuLevel>(level));
+    if (kernels == NULL) {
+      continue;
+    }
+    textile::GridSampler sampler(cols, rows, *kernels);
+    const char* name = textile::CpuLevelName(kernels->level);
+    for (int channels = 1; channels <= 3; channels += 2) {
+      // The gray frame stands for the Y plane of NV12.
+      for (int f = 0; f < 2; ++f) {
+        sampler.Downsample(&frames[f][0], width, height, width * channels,
+                           channels, &grids[f]);
+      }
+      if (!GridMatchesMeans(frames[0], width, height, channels, grids[0])) {
+        printf("grid %s %s: MISMATCH with the cell means\n", name,
+               channels == 1 ? "nv12" : "bgr");
+        ok = false;
+      }
+      const double downsample = TimePerCall(seconds, [&] {
+        sampler.Downsample(&frames[0][0], width, height, width * channels,
+                           channels, &grids[0]);
+      });
+      const double compare = TimePerCall(seconds, [&] {
+        textile::CompareGrids(grids[0], grids[1], &diff, *kernels);
+      });
+      printf("grid %dx%d %-6s %s: downsample %.3f ms/frame, compare %.1f us"
+             " (sad %llu)\n", width, height, name,
+             channels == 1 ? "nv12" : "bgr ", downsample * 1e3,
+             compare * 1e6, static_cast<unsigned long long>(diff.sad));
+    }
+  }
+  return ok ? 0 : 2;
+}
+
+/* One pipeline thread's worth of allocations: frames of a few sizes (the
+ * streams of a thread need not share a resolution) that live for a few
+ * frames, and detection vectors of which some are kept much longer, like
+ * the queues of a sink. */
+void ChurnHeap(int thread, const std::atomic<bool>* stop) {
+  textile::BindThreadArena();
+  static const size_t kFrameBytes[] = {
+    1920 * 1080 * 3, 1280 * 720 * 3, 1920 * 1080 * 3 / 2, 640 * 480 * 3
+  };
+  vector<vector<uint8_t> > frames(3);
+  vector<vector<float> > kept(256);
+  srand(thread + 1);
+  for (int64_t i = 0; !stop->load(); ++i) {
+    vector<uint8_t>& frame = frames[i % frames.size()];
+    frame.assign(kFrameBytes[rand() % 4], static_cast<uint8_t>(i));
+    vector<float> detections(7 * (1 + rand() % 100), 1.f);
+    if (rand() % 8 == 0) {
+      kept[rand() % kept.size()].swap(detections);
+    }
+  }
+}
+
+int BenchHeap() {
+  textile::ConfigureAllocator(FLAGS_bench_arenas,
+                              FLAGS_bench_mmap_threshold);
+  std::atomic<bool> stop(false);
+  vector<std::thread> threads;
+  for (int t = 0; t < FLAGS_bench_threads; ++t) {
+    threads.push_back(std::thread(ChurnHeap, t, &stop));
+  }
+  const Clock::time_point start = Clock::now();
+  int64_t first_rss = 0;
+  textile::MemoryReport report;
+  do {
+    std::this_thread::sleep_for(std::chrono::duration<double>(
+        std::min(FLAGS_bench_report_s,
+                 FLAGS_bench_seconds - Seconds(Clock::now() - start))));
+    report = textile::MemoryReport();
+    textile::AccountProcess(&report);
+    if (first_rss == 0) {
+      first_rss = report.rss;
+    }
+    printf("heap %s %8.0f s: in use %.1f MiB, mapped %.1f MiB,"
+           " rss %.1f MiB\n", textile::AllocatorName(),
+           Seconds(Clock::now() - start), report.heap_in_use / 1048576.,
+           report.heap_mapped / 1048576., report.rss / 1048576.);
+  } while (Seconds(Clock::now() - start) < FLAGS_bench_seconds);
+  stop = true;
+  for (size_t t = 0; t < threads.size(); ++t) {
+    threads[t].join();
+  }
+  const double growth =
+      first_rss > 0 ? static_cast<double>(report.rss) / first_rss : 1.;
+  printf("heap %s: rss grew %.2fx with %d threads\n", textile::AllocatorName(),
+         growth, FLAGS_bench_threads);
+  return growth <= FLAGS_bench_max_growth ? 0 : 2;
+}
+
+struct Benchmark {
+  const char* name;
+  int (*run)();
+};
+
+const Benchmark kBenchmarks[] = {
+#ifdef USE_SQLITE
+  {"sqlite", BenchSqlite},
+#endif  // USE_SQLITE
+  {"nms", BenchNms},
+  {"grid", BenchGrid},
+  {"heap", BenchHeap},
+  {NULL, NULL}
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ::google::InitGoogleLogging(argv[0]);
+  FLAGS_alsologtostderr = 1;
+
+#ifndef GFLAGS_GFLAGS_H_
+  namespace gflags = google;
+#endif
+
+  gflags::SetUsageMessage("Benchmark pipeline components.\n"
+        "Usage:\n"
+        "    textile_bench [FLAGS] -bench name\n");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  for (const Benchmark* b = kBenchmarks; b->name != NULL; ++b) {
+    if (FLAGS_bench == b->name) {
+      return b->run();
+    }
+  }
+  std::cerr << "Unknown or unavailable benchmark '" << FLAGS_bench
+            << "'; built in:";
+  for (const Benchmark* b = kBenchmarks; b->name != NULL; ++b) {
+    std::cerr << " " << b->name;
+  }
+  std::cerr << std::endl;
+  return 1;
+}
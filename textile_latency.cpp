@@ -0,0 +1,156 @@
+// Glass-to-frame latency of a camera, measured with a clock test pattern.
+// Usage:
+//    textile_latency -show [FLAGS]
+//    textile_latency [FLAGS] -config file -camera name
+//
+// -show fills a window with the clock pattern of textile/clock_pattern.hpp,
+// updated as fast as the screen allows. Point the camera at it (or have the
+// replay server capture it) and run the second form on the same machine,
+// or one with a synchronized clock: every frame read from the camera's
+// stream, with its capture settings from the config file, is decoded and
+// its age - the time from the pattern being on the glass to the frame
+// being in hand - is collected. The pattern should fill the camera's roi.
+//
+#include <stdint.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "textile/clock_pattern.hpp"
+#include "textile/config.hpp"
+#include "textile/detection_sink.hpp"
+#include "textile/frame_source.hpp"
+
+using std::string;
+using std::vector;
+
+DEFINE_bool(show, false, "Show the clock pattern instead of measuring.");
+DEFINE_string(pattern_size, "1280x160", "-show: size of the pattern window.");
+DEFINE_string(config, "", "The config file with the camera.");
+DEFINE_string(camera, "", "The camera to measure; the first one if empty.");
+DEFINE_int32(samples, 200, "Frames to read.");
+DEFINE_double(seconds, 60., "Give up after this long.");
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+int ShowPattern() {
+  int width = 0;
+  int height = 0;
+  char x = 0;
+  if (sscanf(FLAGS_pattern_size.c_str(), "%d%c%d", &width, &x, &height) != 3 ||
+      x != 'x' || width < 50 || height < 1) {
+    LOG(ERROR) << "Bad -pattern_size " << FLAGS_pattern_size;
+    return 1;
+  }
+  cv::Mat pattern(height, width, CV_8UC1);
+  cv::namedWindow("clock");
+  // Esc quits.
+  while (true) {
+    textile::DrawClockPattern(textile::WallTimeMs(), &pattern);
+    cv::imshow("clock", pattern);
+    if (cv::waitKey(1) == 27) {
+      return 0;
+    }
+  }
+}
+
+const textile::CameraConfig* FindCamera(const textile::Config& config) {
+  for (size_t i = 0; i < config.cameras.size(); ++i) {
+    if (FLAGS_camera.empty() || config.cameras[i].name == FLAGS_camera) {
+      return &config.cameras[i];
+    }
+  }
+  return NULL;
+}
+
+int Measure() {
+  std::shared_ptr<const textile::Config> config =
+      textile::LoadConfigOrDie(FLAGS_config);
+  const textile::CameraConfig* camera = FindCamera(*config);
+  if (camera == NULL) {
+    LOG(ERROR) << "No camera " << FLAGS_camera << " in " << FLAGS_config;
+    return 1;
+  }
+  std::unique_ptr<textile::FrameSource> stream =
+      textile::CreateFrameSource(*camera);
+  stream->Open();
+
+  vector<int64_t> ages;
+  int frames = 0;
+  const Clock::time_point end =
+      Clock::now() + std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(FLAGS_seconds));
+  textile::Frame frame;
+  while (frames < FLAGS_samples && Clock::now() < end) {
+    stream->Read(&frame);
+    // Take the time first: decoding the pattern is not capture latency.
+    const int64_t now = textile::WallTimeMs();
+    if (frame.image.empty()) {
+      continue;
+    }
+    ++frames;
+    cv::Rect roi(0, 0, frame.image.cols, frame.image.rows);
+    if (!camera->roi.empty()) {
+      roi &= cv::Rect(camera->roi.x, camera->roi.y, camera->roi.width,
+                      camera->roi.height);
+    }
+    int64_t pattern_ms;
+    if (textile::ReadClockPattern(frame.image(roi), &pattern_ms)) {
+      ages.push_back(textile::ClockPatternAge(now, pattern_ms));
+    }
+    frame.Release();
+  }
+
+  printf("%s: read %d frames, %d with a readable clock\n",
+         camera->name.c_str(), frames, static_cast<int>(ages.size()));
+  if (ages.empty()) {
+    return 2;
+  }
+  std::sort(ages.begin(), ages.end());
+  const size_t n = ages.size();
+  printf("%s: glass-to-frame latency p50 %lld ms, p90 %lld ms, p99 %lld ms,"
+         " max %lld ms\n", camera->name.c_str(),
+         static_cast<long long>(ages[n / 2]),
+         static_cast<long long>(ages[n * 9 / 10]),
+         static_cast<long long>(ages[n * 99 / 100]),
+         static_cast<long long>(ages[n - 1]));
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ::google::InitGoogleLogging(argv[0]);
+  FLAGS_alsologtostderr = 1;
+
+#ifndef GFLAGS_GFLAGS_H_
+  namespace gflags = google;
+#endif
+
+  gflags::SetUsageMessage("Measure the capture latency of a camera.\n"
+        "Usage:\n"
+        "    textile_latency -show [FLAGS]\n"
+        "    textile_latency [FLAGS] -config file -camera name\n");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  if (FLAGS_show) {
+    return ShowPattern();
+  }
+  if (FLAGS_config.empty()) {
+    gflags::ShowUsageWithFlagsRestrict(argv[0], "textile_latency");
+    return 1;
+  }
+  return Measure();
+}
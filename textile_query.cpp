@@ -0,0 +1,284 @@
+// Ad-hoc queries over the columnar detection store written by
+// detect_textile -store_dir.
+// Usage:
+//    textile_query [FLAGS] store_dir
+//
+// Counts the detections that match the filter flags, grouped by any of
+// camera, model, label, day, hour and shift, e.g. defects per class per
+// loom per shift over a month:
+//    textile_query -from 2024-03-01 -to 2024-04-01
+//        -group_by camera,label,shift /data/detections
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "textile/columnar_store.hpp"
+
+using std::string;
+using std::vector;
+
+DEFINE_string(from, "",
+    "Only detections at or after this local time: YYYY-MM-DD[ HH:MM[:SS]]"
+    " or milliseconds since the epoch.");
+DEFINE_string(to, "",
+    "Only detections before this local time, in the format of -from.");
+DEFINE_string(camera, "", "Comma-separated cameras to include; all if empty.");
+DEFINE_string(model, "", "Only detections of this model.");
+DEFINE_int32(label, -1, "Only detections of this label; all if negative.");
+DEFINE_double(min_score, 0., "Only detections scoring at least this.");
+DEFINE_string(group_by, "label",
+    "Comma-separated keys to count by: camera, model, label, day, hour,"
+    " shift. Empty counts everything together.");
+DEFINE_string(shifts, "06:00,14:00,22:00",
+    "Local start times of the shifts, for -group_by shift.");
+
+namespace {
+
+enum Key { kKeyCamera, kKeyModel, kKeyLabel, kKeyDay, kKeyHour, kKeyShift };
+
+const int kMaxKeys = 6;
+const char* const kKeyNames[kMaxKeys] =
+    {"camera", "model", "label", "day", "hour", "shift"};
+const int64_t kMsPerDay = 86400000;
+
+vector<string> Split(const string& s) {
+  vector<string> items;
+  std::stringstream ss(s);
+  string item;
+  while (getline(ss, item, ',')) {
+    if (!item.empty()) {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+/* Parse a -from/-to value into milliseconds since the epoch. */
+int64_t ParseTime(const string& value) {
+  if (value.find_first_not_of("0123456789") == string::npos) {
+    return strtoll(value.c_str(), NULL, 10);
+  }
+  struct tm tm;
+  memset(&tm, 0, sizeof(tm));
+  int fields = sscanf(value.c_str(), "%d-%d-%d %d:%d:%d", &tm.tm_year,
+                      &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min,
+                      &tm.tm_sec);
+  CHECK(fields == 3 || fields == 5 || fields == 6)
+    << "Bad time: " << value;
+  tm.tm_year -= 1900;
+  tm.tm_mon -= 1;
+  tm.tm_isdst = -1;
+  return static_cast<int64_t>(mktime(&tm)) * 1000;
+}
+
+/* Minutes after midnight of each shift start, sorted. */
+vector<int> ParseShifts(const string& value) {
+  vector<int> starts;
+  const vector<string> items = Split(value);
+  for (size_t i = 0; i < items.size(); ++i) {
+    int hour = 0;
+    int minute = 0;
+    CHECK_EQ(sscanf(items[i].c_str(), "%d:%d", &hour, &minute), 2)
+      << "Bad shift start: " << items[i];
+    starts.push_back(hour * 60 + minute);
+  }
+  CHECK(!starts.empty()) << "-shifts is empty";
+  std::sort(starts.begin(), starts.end());
+  return starts;
+}
+
+struct GroupKey {
+  bool operator<(const GroupKey& other) const {
+    return std::lexicographical_compare(v, v + kMaxKeys,
+                                        other.v, other.v + kMaxKeys);
+  }
+  int64_t v[kMaxKeys];
+};
+
+/* Counts selected rows per group. Strings (cameras, models) are replaced
+ * by indexes into dictionaries shared across segments. */
+class Counter : public textile::SegmentVisitor {
+ public:
+  Counter(const vector<Key>& keys, const vector<int>& shifts)
+      : keys_(keys), shifts_(shifts) {}
+
+  unsigned Columns() const {
+    unsigned columns = 0;
+    for (size_t k = 0; k < keys_.size(); ++k) {
+      if (keys_[k] == kKeyModel) {
+        columns |= 1u << textile::kColModel;
+      } else if (keys_[k] == kKeyLabel) {
+        columns |= 1u << textile::kColLabel;
+      } else if (keys_[k] != kKeyCamera) {
+        columns |= 1u << textile::kColTime;
+      }
+    }
+    return columns;
+  }
+
+  virtual void Visit(const textile::SegmentRows& rows) {
+    const int64_t camera = Intern(rows.camera, &cameras_);
+    vector<int64_t> models(rows.models.size());
+    for (size_t m = 0; m < rows.models.size(); ++m) {
+      models[m] = Intern(rows.models[m], &models_);
+    }
+    // Local time of every row, with the UTC offset in effect when the
+    // segment was started.
+    const time_t start = static_cast<time_t>(rows.header.min_time_ms / 1000);
+    struct tm tm;
+    localtime_r(&start, &tm);
+    const int64_t offset_ms = static_cast<int64_t>(tm.tm_gmtoff) * 1000;
+
+    GroupKey key;
+    std::fill(key.v, key.v + kMaxKeys, 0);
+    for (size_t i = 0; i < rows.selected.size(); ++i) {
+      if (!rows.selected[i]) {
+        continue;
+      }
+      const int64_t local_ms =
+          rows.time_ms.empty() ? 0 : rows.time_ms[i] + offset_ms;
+      for (size_t k = 0; k < keys_.size(); ++k) {
+        int64_t& v = key.v[k];
+        switch (keys_[k]) {
+          case kKeyCamera: v = camera; break;
+          case kKeyModel: v = models[rows.model[i]]; break;
+          case kKeyLabel: v = rows.label[i]; break;
+          case kKeyDay: v = local_ms / kMsPerDay; break;
+          case kKeyHour: v = local_ms % kMsPerDay / 3600000; break;
+          case kKeyShift: v = Shift(local_ms % kMsPerDay / 60000); break;
+        }
+      }
+      ++counts_[key];
+    }
+  }
+
+  void Print(std::ostream& out) const {
+    for (size_t k = 0; k < keys_.size(); ++k) {
+      out << kKeyNames[keys_[k]] << "\t";
+    }
+    out << "count\n";
+    for (std::map<GroupKey, int64_t>::const_iterator it = counts_.begin();
+         it != counts_.end(); ++it) {
+      for (size_t k = 0; k < keys_.size(); ++k) {
+        const int64_t v = it->first.v[k];
+        switch (keys_[k]) {
+          case kKeyCamera: out << cameras_[v]; break;
+          case kKeyModel: out << models_[v]; break;
+          case kKeyDay: out << FormatDay(v); break;
+          case kKeyShift: out << FormatMinute(shifts_[v]); break;
+          default: out << v; break;
+        }
+        out << "\t";
+      }
+      out << it->second << "\n";
+    }
+  }
+
+ private:
+  static int64_t Intern(const string& s, vector<string>* dict) {
+    vector<string>::iterator it = std::find(dict->begin(), dict->end(), s);
+    if (it != dict->end()) {
+      return it - dict->begin();
+    }
+    dict->push_back(s);
+    return dict->size() - 1;
+  }
+
+  /* The shift running at minute of the day; the last one wraps past
+   * midnight. */
+  int64_t Shift(int64_t minute) const {
+    int64_t shift = shifts_.size() - 1;
+    for (size_t s = 0; s < shifts_.size() && shifts_[s] <= minute; ++s) {
+      shift = s;
+    }
+    return shift;
+  }
+
+  static string FormatDay(int64_t day) {
+    const time_t t = static_cast<time_t>(day * 86400);
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    char buf[16];
+    strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
+    return buf;
+  }
+
+  static string FormatMinute(int minute) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%02d:%02d", minute / 60, minute % 60);
+    return buf;
+  }
+
+  vector<Key> keys_;
+  vector<int> shifts_;
+  vector<string> cameras_;
+  vector<string> models_;
+  std::map<GroupKey, int64_t> counts_;
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ::google::InitGoogleLogging(argv[0]);
+  FLAGS_alsologtostderr = 1;
+
+#ifndef GFLAGS_GFLAGS_H_
+  namespace gflags = google;
+#endif
+
+  gflags::SetUsageMessage("Query the columnar detection store.\n"
+        "Usage:\n"
+        "    textile_query [FLAGS] store_dir\n");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  if (argc < 2) {
+    gflags::ShowUsageWithFlagsRestrict(argv[0], "textile_query");
+    return 1;
+  }
+
+  textile::ScanFilter filter;
+  if (!FLAGS_from.empty()) {
+    filter.from_ms = ParseTime(FLAGS_from);
+  }
+  if (!FLAGS_to.empty()) {
+    filter.to_ms = ParseTime(FLAGS_to);
+  }
+  filter.cameras = Split(FLAGS_camera);
+  filter.model = FLAGS_model;
+  filter.label = FLAGS_label;
+  filter.min_score = static_cast<float>(FLAGS_min_score);
+
+  vector<Key> keys;
+  const vector<string> names = Split(FLAGS_group_by);
+  for (size_t i = 0; i < names.size(); ++i) {
+    const char* const* name =
+        std::find(kKeyNames, kKeyNames + kMaxKeys, names[i]);
+    CHECK(name != kKeyNames + kMaxKeys)
+      << "Unknown -group_by key: " << names[i];
+    keys.push_back(static_cast<Key>(name - kKeyNames));
+  }
+  CHECK_LE(keys.size(), static_cast<size_t>(kMaxKeys));
+
+  Counter counter(keys, ParseShifts(FLAGS_shifts));
+  textile::ScanStats stats;
+  CHECK(textile::ScanStore(argv[1], filter, counter.Columns(), &counter,
+                           &stats))
+    << "Unable to read " << argv[1];
+  counter.Print(std::cout);
+  LOG(INFO) << "Scanned " << stats.segments_read << " of " << stats.segments
+            << " segments, " << stats.rows_selected << " of "
+            << stats.rows_read << " rows matched";
+  return 0;
+}